@@ -0,0 +1,33 @@
+#ifndef CULLING_HIZBUFFER_HPP
+#define CULLING_HIZBUFFER_HPP
+
+#include <glad/gl.h>
+#include "math/vector.hpp"
+#include "shader.hpp"
+#include "utils/noncopyable.hpp"
+
+// Hierarchical depth buffer: a mip chain where each texel holds the farthest
+// depth of the texels it covers in the level below.
+class HiZBuffer : private NonCopyable {
+public:
+    HiZBuffer();
+    ~HiZBuffer();
+
+    explicit operator bool() const { return static_cast<bool>(shader); }
+
+    GLuint getTexture() const { return texture; }
+    const Vector2i& getSize() const { return size; }
+    int getLevelCount() const { return levelCount; }
+
+    void build(GLuint depthTexture, const Vector2i& depthSize);
+
+private:
+    Shader shader;
+    GLuint texture;
+    Vector2i size;
+    int levelCount;
+
+    void resize(const Vector2i& size);
+};
+
+#endif
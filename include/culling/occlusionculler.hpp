@@ -0,0 +1,99 @@
+#ifndef CULLING_OCCLUSIONCULLER_HPP
+#define CULLING_OCCLUSIONCULLER_HPP
+
+#include <array>
+#include <span>
+#include <glad/gl.h>
+#include "culling/hizbuffer.hpp"
+#include "framebuffer.hpp"
+#include "math/boundingbox.hpp"
+#include "math/matrix.hpp"
+#include "mesh.hpp"
+#include "shader.hpp"
+#include "utils/noncopyable.hpp"
+
+// GPU two-phase occlusion culling of mesh instances.
+//
+// The early phase draws the instances that were visible last frame, the Hi-Z
+// pyramid is rebuilt from the resulting depth buffer, and the late phase tests
+// every instance against it and draws the ones that became visible. Instances
+// are drawn with the instanced vertex shader, which reads model matrices from
+// binding 0 and the visible instance list from binding 2.
+//
+// For multi-view rendering, draws are issued once per view and instance; the
+// vertex shader derives both from gl_InstanceID. Occlusion culling needs a
+// single view.
+class OcclusionCuller : private NonCopyable {
+public:
+    struct Statistics {
+        int instanceCount = 0;
+        int earlyDrawCount = 0;
+        int lateDrawCount = 0;
+        int frustumCulledCount = 0;
+        int occlusionCulledCount = 0;
+    };
+
+    explicit OcclusionCuller(int capacity);
+    ~OcclusionCuller();
+
+    explicit operator bool() const { return cullShader && hiz; }
+
+    void setInstances(std::span<const Matrix4f> models, const BoundingBox& bounds);
+    void setOcclusionCulling(bool enabled) { occlusionCulling = enabled; }
+    void setViewCount(int viewCount);
+
+    void render(const Matrix4f& viewProjection, const Framebuffer& framebuffer, Shader& shader, const Mesh& mesh, Mesh::Stream stream = Mesh::Stream::All);
+
+    // Draws the instances found visible by the last render() again, e.g. for
+    // the color pass after a depth pre-pass.
+    void redraw(Shader& shader, const Mesh& mesh, Mesh::Stream stream = Mesh::Stream::All) const;
+
+    // Statistics lag a couple of frames behind so that reading them never stalls.
+    const Statistics& getStatistics() const { return statistics; }
+
+private:
+    struct DrawCommand {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    struct Counters {
+        DrawCommand commands[2];
+        GLuint frustumCulledCount;
+        GLuint occlusionCulledCount;
+    };
+
+    struct Readback {
+        GLuint buffer = 0;
+        const Counters* counters = nullptr;
+        GLsync fence = nullptr;
+        int instanceCount = 0;
+        int viewCount = 1;
+    };
+
+    static constexpr int ReadbackCount = 3;
+
+    Shader cullShader;
+    HiZBuffer hiz;
+    int capacity;
+    int instanceCount;
+    BoundingBox bounds;
+    bool occlusionCulling;
+    int viewCount;
+    GLuint modelBuffer;
+    GLuint visibilityBuffer;
+    GLuint instanceBuffer;
+    GLuint counterBuffer;
+    std::array<Readback, ReadbackCount> readbacks;
+    int readbackIndex;
+    Statistics statistics;
+
+    void bindBuffers() const;
+    void cull(int phase, const Matrix4f& viewProjection);
+    void readStatistics();
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef CULLING_OCCLUSIONQUERIES_HPP
+#define CULLING_OCCLUSIONQUERIES_HPP
+
+#include <span>
+#include <vector>
+#include <glad/gl.h>
+#include "math/matrix.hpp"
+#include "mesh.hpp"
+#include "shader.hpp"
+#include "uniformring.hpp"
+#include "utils/noncopyable.hpp"
+
+// Hardware occlusion queries for a few large, expensive objects.
+//
+// The bounding box of an object is drawn without color or depth writes inside
+// an occlusion query, and the object itself is drawn under conditional
+// rendering on that query: the GPU skips the draw when no sample passed, and
+// the CPU never waits for a result. Objects known to be visible are only
+// queried again every requeryInterval frames and drawn unconditionally in
+// between; occluded objects are queried every frame. Results are read back
+// once available, only to drive that schedule and the statistics.
+//
+// Occluders must already be in the depth buffer when render() is called.
+//
+// With several view projections, boxes and objects are drawn once per view of
+// the bound MultiView, and a query passes when the box is visible in any of
+// them.
+class OcclusionQueries : private NonCopyable {
+public:
+    struct Object {
+        const Mesh* mesh;
+        Matrix4f model;
+    };
+
+    struct Statistics {
+        int objectCount = 0;
+        int queryCount = 0;
+        int conditionalDrawCount = 0;
+        int skippedDrawCount = 0;
+        int skippedTriangleCount = 0;
+    };
+
+    explicit OcclusionQueries(int capacity, int requeryInterval = 8);
+    ~OcclusionQueries();
+
+    explicit operator bool() const { return boundsShader && multiViewBoundsShader; }
+
+    void setEnabled(bool enabled) { this->enabled = enabled; }
+    void setRequeryInterval(int frames) { requeryInterval = frames; }
+
+    // Objects are identified by their index, which must be stable from one
+    // frame to the next. The model of each object is bound with uniforms.
+    void render(std::span<const Matrix4f> viewProjections, std::span<const Object> objects, Shader& shader, UniformRing& uniforms);
+
+    // Skipped draws are known from the last results read back.
+    const Statistics& getStatistics() const { return statistics; }
+
+private:
+    struct State {
+        GLuint query;
+        int lastQueryFrame;
+        bool pending;
+        bool visible;
+    };
+
+    Shader boundsShader;
+    Shader multiViewBoundsShader;
+    int capacity;
+    int requeryInterval;
+    bool enabled;
+    GLuint vertexArray;
+    std::vector<State> states;
+    int frame;
+    Statistics statistics;
+
+    void readResult(State& state) const;
+    void drawBounds(std::span<const Matrix4f> viewProjections, const Object& object, GLuint query);
+};
+
+#endif
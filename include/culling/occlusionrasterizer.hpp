@@ -0,0 +1,54 @@
+#ifndef CULLING_OCCLUSIONRASTERIZER_HPP
+#define CULLING_OCCLUSIONRASTERIZER_HPP
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "math/boundingbox.hpp"
+#include "math/matrix.hpp"
+#include "math/vector.hpp"
+#include "mesh.hpp"
+#include "utils/noncopyable.hpp"
+#include "utils/threadpool.hpp"
+
+// Low resolution CPU depth buffer for occlusion culling before draw submission.
+//
+// Occluder triangles are transformed and binned into tiles on the calling
+// thread, then tiles are rasterized in parallel, four pixels at a time. Once
+// rasterized, visibility queries are read-only and may run concurrently.
+class OcclusionRasterizer : private NonCopyable {
+public:
+    static constexpr int TileWidth = 64;
+    static constexpr int TileHeight = 32;
+
+    explicit OcclusionRasterizer(ThreadPool& threadPool, const Vector2i& size = Vector2i{ 512, 256 });
+
+    const Vector2i& getSize() const { return size; }
+    int getTriangleCount() const { return static_cast<int>(triangles.size()); }
+
+    void begin(const Matrix4f& viewProjection);
+    void addOccluder(std::span<const Mesh::Vertex> vertices, std::span<const unsigned int> indices, const Matrix4f& model);
+    void rasterize();
+
+    bool isVisible(const BoundingBox& bounds, const Matrix4f& model) const;
+    int testVisibility(const BoundingBox& bounds, std::span<const Matrix4f> models, std::span<std::uint8_t> visible) const;
+
+private:
+    struct Triangle {
+        Vector3f vertices[3];
+    };
+
+    ThreadPool& threadPool;
+    Vector2i size;
+    Vector2i tileCount;
+    Matrix4f viewProjection;
+    std::vector<float> depth;
+    std::vector<float> tileMaxDepth;
+    std::vector<Triangle> triangles;
+    std::vector<std::vector<int>> bins;
+
+    void addTriangle(const Vector4f& c0, const Vector4f& c1, const Vector4f& c2);
+    void rasterizeTile(int tile);
+};
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef DEBUGDRAW_HPP
+#define DEBUGDRAW_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include <glad/gl.h>
+#include "framering.hpp"
+#include "math/boundingbox.hpp"
+#include "math/matrix.hpp"
+#include "math/vector.hpp"
+#include "shader.hpp"
+#include "utils/noncopyable.hpp"
+
+// Immediate mode debug geometry.
+//
+// Primitives are expanded into a persistently mapped vertex ring, one region
+// per frame in flight, and flushed with one draw per primitive type. Appending
+// only reserves space with an atomic increment, so any thread may emit
+// geometry between begin() and flush(); begin() and flush() must be called
+// from the GL thread. Geometry beyond the per-frame capacity is dropped.
+//
+// With several views, flush() draws every primitive once per view of the
+// bound MultiView instead of using the view projection.
+class DebugDraw : private NonCopyable {
+public:
+    explicit DebugDraw(int capacity = 1 << 17);
+    ~DebugDraw();
+
+    explicit operator bool() const { return shader && multiViewShader; }
+
+    int getDroppedVertexCount() const { return droppedVertexCount; }
+
+    void begin();
+    void flush(const Matrix4f& viewProjection, int viewCount = 1);
+
+    void line(const Vector3f& a, const Vector3f& b, const Vector3f& color);
+    void polyline(std::span<const Vector3f> points, const Vector3f& color);
+    void box(const BoundingBox& box, const Vector3f& color);
+    void box(const BoundingBox& box, const Matrix4f& model, const Vector3f& color);
+    void solidBox(const BoundingBox& box, const Vector3f& color);
+    void sphere(const Vector3f& center, float radius, const Vector3f& color);
+    void arrow(const Vector3f& from, const Vector3f& to, const Vector3f& color);
+    void frustum(float fovY, float aspect, float zNear, float zFar, const Vector3f& color);
+
+private:
+    struct Vertex {
+        Vector3f position;
+        std::uint32_t color;
+    };
+
+    enum Primitive {
+        Lines,
+        Triangles,
+        PrimitiveCount
+    };
+
+    Shader shader;
+    Shader multiViewShader;
+    int capacity;
+    GLuint vertexArray;
+    GLuint vertexBuffer;
+    Vertex* vertices;
+    FrameRing ring;
+    std::array<std::atomic<int>, PrimitiveCount> counts;
+    std::atomic<int> droppedVertexCount;
+
+    Vertex* reserve(Primitive primitive, int count);
+    void boxLines(const std::array<Vector3f, 8>& corners, const Vector3f& color);
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef DELETIONQUEUE_HPP
+#define DELETIONQUEUE_HPP
+
+#include <glad/gl.h>
+
+// Deferred deletion of GL objects.
+//
+// Owners enqueue the names of their objects from their destructor, on any
+// thread, instead of deleting them while frames in flight may still use
+// them. Once per frame, on the GL thread, retire() puts a fence behind the
+// names enqueued since the last call and deletes in bulk every batch whose
+// fence has signaled.
+//
+// The queue is process wide since owners know nothing of the renderer.
+class DeletionQueue {
+public:
+    enum class Type {
+        Buffer,
+        VertexArray,
+        Shader,
+        Program
+    };
+
+    struct Statistics {
+        int pendingCount = 0;
+        int deletedCount = 0;
+        float milliseconds = 0;
+    };
+
+    DeletionQueue() = delete;
+
+    // Name 0 is ignored, like glDelete* does.
+    static void enqueue(Type type, GLuint name);
+
+    // Must be called on the GL thread after the frame has been submitted.
+    static void retire();
+
+    // Waits for the GPU and deletes everything, before the context goes away.
+    static void flush();
+
+    // Of the last retire().
+    static Statistics getStatistics();
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef DYNAMICRESOLUTION_HPP
+#define DYNAMICRESOLUTION_HPP
+
+#include "gputimer.hpp"
+#include "utils/noncopyable.hpp"
+
+// Scales the render resolution to hold the GPU time of a frame, measured
+// between begin() and end(), under a budget.
+//
+// Cost grows with the pixel count, so overruns shrink the scale right away by
+// the square root of the overrun. The scale grows back one step at a time
+// once frames have stayed comfortably under budget for a while. Timings are a
+// few frames late: after every change, the controller waits for them to
+// reflect the new resolution. Scales are quantized so that render targets are
+// only reallocated on actual changes.
+class DynamicResolution : private NonCopyable {
+public:
+    DynamicResolution();
+
+    // Disabled, the scale is 1.
+    void setEnabled(bool enabled);
+    void setBudget(float milliseconds);
+    void setMinScale(float minScale);
+
+    float getScale() const { return scale; }
+    float getMilliseconds() const { return timer.getMilliseconds(); }
+
+    void begin();
+    void end();
+
+private:
+    GpuTimer timer;
+    bool enabled;
+    float budget;
+    float minScale;
+    float scale;
+    int cooldown;
+    int underBudgetFrameCount;
+
+    void setScale(float scale);
+};
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef FRAMEBUFFER_HPP
+#define FRAMEBUFFER_HPP
+
+#include <glad/gl.h>
+#include "math/vector.hpp"
+#include "utils/noncopyable.hpp"
+
+class Framebuffer : private NonCopyable {
+public:
+    explicit Framebuffer(const Vector2i& size, GLenum colorFormat = GL_RGBA8);
+    ~Framebuffer();
+
+    const Vector2i& getSize() const { return size; }
+    GLuint getColorTexture() const { return colorTexture; }
+    GLuint getDepthTexture() const { return depthTexture; }
+
+    void resize(const Vector2i& size);
+
+    void bind() const;
+
+private:
+    GLuint framebuffer;
+    GLuint colorTexture;
+    GLuint depthTexture;
+    GLenum colorFormat;
+    Vector2i size;
+
+    void createAttachments();
+    void destroyAttachments();
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef FRAMERING_HPP
+#define FRAMERING_HPP
+
+#include <array>
+#include <glad/gl.h>
+#include "utils/noncopyable.hpp"
+
+// Region bookkeeping for persistently mapped rings, one region per frame in
+// flight. advance() moves to the next region and waits until the GPU is done
+// with the commands fenced while it was last current, so that the caller may
+// rewrite it.
+class FrameRing : private NonCopyable {
+public:
+    static constexpr int FrameCount = 3;
+
+    FrameRing();
+    ~FrameRing();
+
+    // Index of the current region.
+    int getFrame() const { return frame; }
+
+    void advance();
+
+    // Guards the current region with the commands issued so far. Fencing
+    // again replaces the previous fence.
+    void fence();
+
+    // Waits for every region, before the ring storage is released.
+    void wait();
+
+private:
+    std::array<GLsync, FrameCount> fences;
+    int frame;
+
+    void wait(GLsync& fence);
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef GEOMETRYPOOL_HPP
+#define GEOMETRYPOOL_HPP
+
+#include <span>
+#include <vector>
+#include <glad/gl.h>
+#include "math/matrix.hpp"
+#include "mesh.hpp"
+#include "shader.hpp"
+#include "utils/noncopyable.hpp"
+
+// Shared storage for many meshes, fetched by the vertex shader itself
+// (shaders/pulling.vs.glsl) instead of going through vertex array state.
+//
+// Vertices are stored compressed (float position, RGBA8 color, half float
+// texture coordinates: 20 bytes instead of 32). All queued draws are submitted
+// with a single multi-draw over an empty vertex array, whatever mesh they use.
+class GeometryPool : private NonCopyable {
+public:
+    GeometryPool(int vertexCapacity, int indexCapacity, int drawCapacity, int modelCapacity);
+    ~GeometryPool();
+
+    // Returns a handle to pass to addDraw().
+    int addMesh(std::span<const Mesh::Vertex> vertices, std::span<const unsigned int> indices);
+
+    void clearDraws();
+    void addDraw(int mesh, std::span<const Matrix4f> models);
+
+    // Each model is drawn viewCount times for the multi-view shaders, see
+    // MultiView.
+    void draw(Shader& shader, int viewCount = 1) const;
+
+private:
+    struct MeshRange {
+        GLuint firstIndex;
+        GLuint indexCount;
+        GLuint baseVertex;
+    };
+
+    struct DrawCommand {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint first;
+        GLuint baseInstance;
+    };
+
+    struct DrawRecord {
+        GLuint baseVertex;
+        GLuint firstModel;
+    };
+
+    static constexpr int VertexSize = 5;
+
+    int vertexCapacity;
+    int indexCapacity;
+    int drawCapacity;
+    int modelCapacity;
+    int vertexCount;
+    int indexCount;
+    std::vector<MeshRange> meshes;
+    std::vector<DrawCommand> commands;
+    std::vector<DrawRecord> records;
+    std::vector<Matrix4f> models;
+    GLuint vertexArray;
+    GLuint vertexBuffer;
+    GLuint indexBuffer;
+    GLuint commandBuffer;
+    GLuint recordBuffer;
+    GLuint modelBuffer;
+};
+
+#endif
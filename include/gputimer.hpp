@@ -0,0 +1,30 @@
+#ifndef GPUTIMER_HPP
+#define GPUTIMER_HPP
+
+#include <array>
+#include <glad/gl.h>
+#include "utils/noncopyable.hpp"
+
+// Measures GPU time between begin() and end() with timestamp queries, so
+// timers may be nested or interleaved. Results are read a few frames late to
+// avoid stalling on the GPU.
+class GpuTimer : private NonCopyable {
+public:
+    GpuTimer();
+    ~GpuTimer();
+
+    void begin();
+    void end();
+
+    float getMilliseconds() const { return milliseconds; }
+
+private:
+    static constexpr int FrameCount = 4;
+
+    std::array<GLuint, 2 * FrameCount> queries;
+    std::array<bool, FrameCount> pending;
+    int index;
+    float milliseconds;
+};
+
+#endif
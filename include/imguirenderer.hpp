@@ -0,0 +1,49 @@
+#ifndef IMGUIRENDERER_HPP
+#define IMGUIRENDERER_HPP
+
+#include <glad/gl.h>
+#include "framering.hpp"
+#include "math/vector.hpp"
+#include "shader.hpp"
+#include "utils/noncopyable.hpp"
+
+struct ImDrawData;
+struct ImDrawVert;
+
+// ImGui renderer backend.
+//
+// Draw lists are copied into a persistently mapped ring, one region per frame
+// in flight, and drawn with one glDrawElementsBaseVertex per command. Nothing
+// is queried or saved: the state the overlay needs is set before drawing and
+// put back to the renderer defaults (depth test and culling on, blending and
+// scissor off) afterwards. The ring grows when a frame does not fit.
+//
+// Must be created after the ImGui context and destroyed before it.
+class ImGuiRenderer : private NonCopyable {
+public:
+    explicit ImGuiRenderer(int vertexCapacity = 1 << 16, int indexCapacity = 1 << 17);
+    ~ImGuiRenderer();
+
+    explicit operator bool() const { return static_cast<bool>(shader); }
+
+    // Draws into the framebuffer currently bound.
+    void render(const ImDrawData& drawData);
+
+private:
+    Shader shader;
+    int vertexCapacity;
+    int indexCapacity;
+    GLuint vertexArray;
+    GLuint buffer;
+    ImDrawVert* vertices;
+    void* indices;
+    GLintptr indexOffset;
+    GLuint fontTexture;
+    FrameRing ring;
+
+    void createBuffer();
+    void destroyBuffer();
+    void setupState(const ImDrawData& drawData, const Vector2i& framebufferSize);
+};
+
+#endif
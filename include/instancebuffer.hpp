@@ -0,0 +1,30 @@
+#ifndef INSTANCEBUFFER_HPP
+#define INSTANCEBUFFER_HPP
+
+#include <span>
+#include <glad/gl.h>
+#include "math/matrix.hpp"
+#include "utils/noncopyable.hpp"
+
+// Model matrices and an instance index list, bound where the instanced vertex
+// shaders expect them (bindings 0 and 2). Instances drawn with a base instance
+// b read model models[indices[b + gl_InstanceID]].
+class InstanceBuffer : private NonCopyable {
+public:
+    explicit InstanceBuffer(int capacity);
+    ~InstanceBuffer();
+
+    int getCapacity() const { return capacity; }
+
+    void setModels(std::span<const Matrix4f> models);
+    void setIndices(std::span<const unsigned int> indices);
+
+    void bind() const;
+
+private:
+    int capacity;
+    GLuint modelBuffer;
+    GLuint indexBuffer;
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef LIGHTING_CLUSTEREDLIGHTING_HPP
+#define LIGHTING_CLUSTEREDLIGHTING_HPP
+
+#include <span>
+#include <glad/gl.h>
+#include "math/vector.hpp"
+#include "shader.hpp"
+#include "utils/noncopyable.hpp"
+
+// Clustered forward shading: the view frustum is split into a grid of froxels
+// (screen tiles times exponential depth slices) and a compute pass bins every
+// point light into the froxels its sphere touches. Fragments then only loop
+// over the lights of their own froxel.
+//
+// The grid dimensions must match shaders/clusters.glsl.
+class ClusteredLighting : private NonCopyable {
+public:
+    static constexpr int ClusterCountX = 16;
+    static constexpr int ClusterCountY = 9;
+    static constexpr int ClusterCountZ = 24;
+    static constexpr int MaxLightsPerCluster = 128;
+
+    // View space, std430 compatible.
+    struct PointLight {
+        Vector3f position;
+        float radius;
+        Vector3f color;
+        float intensity;
+    };
+
+    explicit ClusteredLighting(int capacity);
+    ~ClusteredLighting();
+
+    explicit operator bool() const { return static_cast<bool>(shader); }
+
+    void setAmbient(float ambient) { this->ambient = ambient; }
+
+    void update(std::span<const PointLight> lights, float fovY, float aspect, float zNear, float zFar);
+
+    // Binds the light buffers and sets the uniforms read by shaders/main.fs.glsl.
+    void apply(Shader& shader) const;
+
+private:
+    Shader shader;
+    int capacity;
+    int lightCount;
+    float ambient;
+    float zNear;
+    float zFar;
+    Vector2f tanHalfFov;
+    GLuint lightBuffer;
+    GLuint clusterBuffer;
+    GLuint lightIndexBuffer;
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef LOD_IMPOSTOR_HPP
+#define LOD_IMPOSTOR_HPP
+
+#include <span>
+#include <vector>
+#include <glad/gl.h>
+#include "math/matrix.hpp"
+#include "math/vector.hpp"
+#include "mesh.hpp"
+#include "shader.hpp"
+#include "utils/noncopyable.hpp"
+
+// Octahedral impostor of a mesh, for instances too far away for even the
+// coarsest level of detail.
+//
+// The mesh is rendered orthographically from frameCount x frameCount view
+// directions laid out on an octahedral map, into an albedo and a normal atlas.
+// Each instance is then drawn as a single quad facing the camera, textured
+// with the frame nearest to its view direction and lit like regular geometry.
+// Instances carry a fade in [0, 1] applied as an ordered dither, so that an
+// impostor can fade in over the mesh it replaces without any sorting.
+class Impostor : private NonCopyable {
+public:
+    Impostor(const Mesh& mesh, int capacity, int frameCount = 8, int frameSize = 64);
+    ~Impostor();
+
+    explicit operator bool() const { return baked; }
+
+    int getInstanceCount() const { return instanceCount; }
+
+    void setInstances(std::span<const Matrix4f> models, std::span<const float> fades);
+
+    // Each instance is drawn viewCount times for the multi-view shaders, see
+    // MultiView.
+    void draw(Shader& shader, int viewCount = 1) const;
+
+private:
+    // Matches ImpostorInstance in shaders/impostor.vs.glsl (std430).
+    struct Instance {
+        Matrix4f model;
+        float fade;
+        float padding[3];
+    };
+
+    int capacity;
+    int frameCount;
+    int frameSize;
+    Vector3f center;
+    float radius;
+    GLuint albedoTexture;
+    GLuint normalTexture;
+    GLuint vertexArray;
+    GLuint instanceBuffer;
+    std::vector<Instance> instances;
+    int instanceCount;
+    bool baked;
+
+    bool bake(const Mesh& mesh);
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef LOD_LODSELECTOR_HPP
+#define LOD_LODSELECTOR_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include "math/boundingbox.hpp"
+#include "math/matrix.hpp"
+#include "utils/noncopyable.hpp"
+#include "utils/threadpool.hpp"
+
+// Picks a detail level per instance from its projected screen-space error.
+//
+// A level is acceptable when its geometric error, projected at the distance of
+// the instance, stays below threshold * 2^bias pixels. Switching to a coarser
+// level requires a margin given by the hysteresis so that instances hovering
+// around a transition distance do not pop back and forth. In budget mode the
+// bias is adjusted every frame to keep the submitted triangle count under the
+// budget.
+class LodSelector : private NonCopyable {
+public:
+    struct Level {
+        float error;
+        int triangleCount;
+    };
+
+    explicit LodSelector(ThreadPool& threadPool);
+
+    void setProjection(float fovY, int viewportHeight);
+    void setThreshold(float pixels) { threshold = pixels; }
+    void setHysteresis(float hysteresis) { this->hysteresis = hysteresis; }
+    void setBias(float bias) { this->bias = bias; }
+    void setTriangleBudget(int budget) { triangleBudget = budget; }
+
+    float getBias() const { return bias; }
+    int getTriangleCount() const { return lastTriangleCount; }
+
+    void beginFrame();
+    void endFrame();
+
+    // Levels are ordered from finest to coarsest. lods holds the level of each
+    // instance from the previous frame and is updated in place.
+    void select(std::span<const Level> levels, const BoundingBox& bounds, std::span<const Matrix4f> models, std::span<std::uint8_t> lods);
+
+private:
+    ThreadPool& threadPool;
+    float pixelsPerUnit;
+    float threshold;
+    float hysteresis;
+    float bias;
+    int triangleBudget;
+    std::atomic<int> triangleCount;
+    int lastTriangleCount;
+};
+
+#endif
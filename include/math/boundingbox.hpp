@@ -0,0 +1,43 @@
+#ifndef MATH_BOUNDINGBOX_HPP
+#define MATH_BOUNDINGBOX_HPP
+
+#include <algorithm>
+#include <limits>
+#include "math/vector.hpp"
+
+class BoundingBox {
+public:
+    Vector3f min;
+    Vector3f max;
+
+    BoundingBox()
+        : min{ std::numeric_limits<float>::max() }
+        , max{ std::numeric_limits<float>::lowest() }
+    {
+    }
+
+    BoundingBox(const Vector3f& min, const Vector3f& max)
+        : min{ min }
+        , max{ max }
+    {
+    }
+
+    bool isEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+
+    Vector3f getCenter() const { return 0.5f * (min + max); }
+    Vector3f getExtents() const { return 0.5f * (max - min); }
+
+    void extend(const Vector3f& p)
+    {
+        min = Vector3f{ std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+        max = Vector3f{ std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+    }
+
+    void extend(const BoundingBox& box)
+    {
+        extend(box.min);
+        extend(box.max);
+    }
+};
+
+#endif
@@ -47,6 +47,7 @@ public:
 };
 
 Matrix4f operator*(const Matrix4f& lhs, const Matrix4f& rhs);
+Vector4f operator*(const Matrix4f& lhs, const Vector4f& rhs);
 
 Matrix4f transpose(const Matrix4f& m);
 
@@ -372,9 +372,178 @@ inline Vector3<T> normalize(const Vector3<T>& v)
     return v / length(v);
 }
 
+template <typename T>
+class Vector4 {
+public:
+    T x;
+    T y;
+    T z;
+    T w;
+
+    Vector4()
+        : x{ 0 }
+        , y{ 0 }
+        , z{ 0 }
+        , w{ 0 }
+    {
+    }
+
+    explicit Vector4(T value)
+        : x{ value }
+        , y{ value }
+        , z{ value }
+        , w{ value }
+    {
+    }
+
+    Vector4(T x, T y, T z, T w)
+        : x{ x }
+        , y{ y }
+        , z{ z }
+        , w{ w }
+    {
+    }
+
+    Vector4(const Vector3<T>& v, T w)
+        : x{ v.x }
+        , y{ v.y }
+        , z{ v.z }
+        , w{ w }
+    {
+    }
+
+    template <typename U>
+    explicit Vector4(const Vector4<U>& v)
+        : x{ static_cast<T>(v.x) }
+        , y{ static_cast<T>(v.y) }
+        , z{ static_cast<T>(v.z) }
+        , w{ static_cast<T>(v.w) }
+    {
+    }
+
+    Vector4<T>& operator+=(const Vector4<T>& rhs)
+    {
+        x += rhs.x;
+        y += rhs.y;
+        z += rhs.z;
+        w += rhs.w;
+
+        return *this;
+    }
+
+    Vector4<T>& operator-=(const Vector4<T>& rhs)
+    {
+        x -= rhs.x;
+        y -= rhs.y;
+        z -= rhs.z;
+        w -= rhs.w;
+
+        return *this;
+    }
+
+    Vector4<T>& operator*=(const Vector4<T>& rhs)
+    {
+        x *= rhs.x;
+        y *= rhs.y;
+        z *= rhs.z;
+        w *= rhs.w;
+
+        return *this;
+    }
+
+    template <typename U>
+    Vector4<T>& operator*=(U rhs)
+    {
+        x *= rhs;
+        y *= rhs;
+        z *= rhs;
+        w *= rhs;
+
+        return *this;
+    }
+
+    Vector4<T>& operator/=(const Vector4<T>& rhs)
+    {
+        x /= rhs.x;
+        y /= rhs.y;
+        z /= rhs.z;
+        w /= rhs.w;
+
+        return *this;
+    }
+
+    template <typename U>
+    Vector4<T>& operator/=(U rhs)
+    {
+        x /= rhs;
+        y /= rhs;
+        z /= rhs;
+        w /= rhs;
+
+        return *this;
+    }
+
+    auto operator<=>(const Vector4<T>&) const = default;
+};
+
+template <typename T>
+inline Vector4<T> operator-(const Vector4<T>& rhs)
+{
+    return Vector4<T>{ -rhs.x, -rhs.y, -rhs.z, -rhs.w };
+}
+
+template <typename T>
+inline Vector4<T> operator+(Vector4<T> lhs, const Vector4<T>& rhs)
+{
+    return lhs += rhs;
+}
+
+template <typename T>
+inline Vector4<T> operator-(Vector4<T> lhs, const Vector4<T>& rhs)
+{
+    return lhs -= rhs;
+}
+
+template <typename T>
+inline Vector4<T> operator*(Vector4<T> lhs, const Vector4<T>& rhs)
+{
+    return lhs *= rhs;
+}
+
+template <typename T, typename U>
+inline Vector4<T> operator*(Vector4<T> lhs, U rhs)
+{
+    return lhs *= rhs;
+}
+
+template <typename T, typename U>
+inline Vector4<T> operator*(U lhs, Vector4<T> rhs)
+{
+    return rhs *= lhs;
+}
+
+template <typename T>
+inline Vector4<T> operator/(Vector4<T> lhs, const Vector4<T>& rhs)
+{
+    return lhs /= rhs;
+}
+
+template <typename T, typename U>
+inline Vector4<T> operator/(Vector4<T> lhs, U rhs)
+{
+    return lhs /= rhs;
+}
+
+template <typename T>
+inline T dot(const Vector4<T>& u, const Vector4<T>& v)
+{
+    return u.x * v.x + u.y * v.y + u.z * v.z + u.w * v.w;
+}
+
 using Vector2i = Vector2<int>;
 using Vector2f = Vector2<float>;
 using Vector3i = Vector3<int>;
 using Vector3f = Vector3<float>;
+using Vector4f = Vector4<float>;
 
 #endif
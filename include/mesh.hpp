@@ -3,6 +3,7 @@
 
 #include <span>
 #include <glad/gl.h>
+#include "math/boundingbox.hpp"
 #include "math/vector.hpp"
 #include "utils/noncopyable.hpp"
 
@@ -14,16 +15,31 @@ public:
         Vector2f texCoords;
     };
 
+    // Depth-only passes use a tightly packed position stream, which keeps
+    // their vertex fetch bandwidth to a minimum.
+    enum class Stream {
+        All,
+        Position
+    };
+
     Mesh(std::span<const Vertex> vertices, std::span<const unsigned int> indices);
     ~Mesh();
 
-    void draw() const;
+    int getCount() const { return count; }
+    const BoundingBox& getBounds() const { return bounds; }
+
+    void draw(Stream stream = Stream::All) const;
+    void drawInstanced(int instanceCount, int baseInstance, Stream stream = Stream::All) const;
+    void drawIndirect(GLintptr offset, Stream stream = Stream::All) const;
 
 private:
     GLuint vertexArray;
     GLuint vertexBuffer;
+    GLuint positionVertexArray;
+    GLuint positionBuffer;
     GLuint indexBuffer;
     int count;
+    BoundingBox bounds;
 };
 
 #endif
@@ -0,0 +1,97 @@
+#ifndef MESHBATCHER_HPP
+#define MESHBATCHER_HPP
+
+#include <span>
+#include <vector>
+#include <glad/gl.h>
+#include "framering.hpp"
+#include "math/matrix.hpp"
+#include "mesh.hpp"
+#include "shader.hpp"
+#include "uniformring.hpp"
+#include "utils/noncopyable.hpp"
+
+// Merges small meshes drawn with the same program into single draw calls.
+//
+// Static objects are transformed once by buildStatic() into merged vertex and
+// index buffers. Dynamic objects are transformed on the CPU with SIMD every
+// frame into a persistently mapped ring, one fence-guarded region per frame in
+// flight. Vertices are pre-transformed, so batches are drawn with an identity
+// model matrix.
+//
+// Meshes with more vertices than the threshold, or dynamic objects beyond the
+// per-frame capacity, are refused and must be drawn individually by the
+// caller. The refused count covers the dynamic objects of the current frame.
+class MeshBatcher : private NonCopyable {
+public:
+    struct Statistics {
+        int staticObjectCount = 0;
+        int dynamicObjectCount = 0;
+        int refusedObjectCount = 0;
+        int drawCount = 0;
+        int savedDrawCount = 0;
+    };
+
+    MeshBatcher(int dynamicVertexCapacity, int dynamicIndexCapacity);
+    ~MeshBatcher();
+
+    void setMaxVertexCount(int count) { maxVertexCount = count; }
+
+    // Source geometry is kept on the CPU, the returned handle refers to it.
+    int addMesh(std::span<const Mesh::Vertex> vertices, std::span<const unsigned int> indices);
+
+    void clearStatic();
+    bool addStatic(int mesh, const Matrix4f& model);
+    void buildStatic();
+
+    void beginDynamic();
+    bool addDynamic(int mesh, const Matrix4f& model);
+
+    // May be called several times per frame, e.g. for a depth pre-pass. Each
+    // batch is drawn viewCount times for the multi-view shaders, see MultiView.
+    void draw(Shader& shader, UniformRing& uniforms, int viewCount = 1);
+
+    const Statistics& getStatistics() const { return statistics; }
+
+private:
+    struct SourceMesh {
+        int firstVertex;
+        int vertexCount;
+        int firstIndex;
+        int indexCount;
+    };
+
+    struct StaticObject {
+        int mesh;
+        Matrix4f model;
+    };
+
+    int dynamicVertexCapacity;
+    int dynamicIndexCapacity;
+    int maxVertexCount;
+
+    std::vector<Mesh::Vertex> sourceVertices;
+    std::vector<unsigned int> sourceIndices;
+    std::vector<SourceMesh> meshes;
+
+    std::vector<StaticObject> staticObjects;
+    GLuint staticVertexArray;
+    GLuint staticVertexBuffer;
+    GLuint staticIndexBuffer;
+    int staticIndexCount;
+
+    GLuint dynamicVertexArray;
+    GLuint dynamicVertexBuffer;
+    GLuint dynamicIndexBuffer;
+    Mesh::Vertex* dynamicVertices;
+    unsigned int* dynamicIndices;
+    FrameRing ring;
+    int dynamicVertexCount;
+    int dynamicIndexCount;
+
+    Statistics statistics;
+
+    bool isBatchable(int mesh) const;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef MULTIVIEW_HPP
+#define MULTIVIEW_HPP
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <glad/gl.h>
+#include "math/matrix.hpp"
+#include "math/vector.hpp"
+#include "utils/noncopyable.hpp"
+
+// Several views rendered in a single pass.
+//
+// Views are laid out on a grid of viewports set with glViewportArrayv, and
+// their view projections are stored in a uniform block at binding 0. Geometry
+// is submitted once: instanced draws multiply their instance count by the
+// view count and the MULTI_VIEW variants of the vertex shaders derive the
+// view from gl_InstanceID and write gl_ViewportIndex (shaders/multiview.glsl).
+//
+// Only views sharing the eye are supported. They are given as rotations about
+// the origin rather than as full view matrices: a single frustum then
+// encloses them all, so culling, LOD selection and light binning run once
+// against it, and shading happens in the space common to every view. Views
+// from different positions would need each of those per view.
+//
+// Writing gl_ViewportIndex from a vertex shader needs
+// ARB_shader_viewport_layer_array.
+class MultiView : private NonCopyable {
+public:
+    static constexpr int MaxViewCount = 4;
+
+    // Defined by the shader variants drawing every view.
+    static constexpr std::string_view Keyword = "MULTI_VIEW";
+
+    struct Frustum {
+        float fovY;
+        float aspect;
+        float zNear;
+        float zFar;
+    };
+
+    MultiView();
+    ~MultiView();
+
+    explicit operator bool() const { return supported; }
+
+    // Columns and rows of the viewport grid.
+    static Vector2i getGridSize(int viewCount);
+
+    // Each view is given by its camera orientation around the shared eye.
+    void setViews(std::span<const Matrix4f> rotations, float fovY, float zNear, float zFar, const Vector2i& size);
+
+    int getViewCount() const { return viewCount; }
+    std::span<const Matrix4f> getViewProjections() const { return { uniforms.viewProjections, static_cast<std::size_t>(viewCount) }; }
+
+    // Smallest symmetric frustum around -z enclosing every view.
+    const Frustum& getFrustum() const { return frustum; }
+
+    void bind() const;
+    void unbind(const Vector2i& size) const;
+
+private:
+    // std140.
+    struct Uniforms {
+        Matrix4f viewProjections[MaxViewCount];
+        GLint viewCount;
+        GLint padding[3];
+    };
+
+    bool supported;
+    int viewCount;
+    Frustum frustum;
+    Uniforms uniforms;
+    GLfloat viewports[4 * MaxViewCount];
+    GLuint uniformBuffer;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef PLATFORM_HPP
+#define PLATFORM_HPP
+
+#include <memory>
+#include "imguirenderer.hpp"
+#include "utils/noncopyable.hpp"
+
+struct GLFWwindow;
+
+// Process wide GLFW, OpenGL and ImGui state.
+//
+// A hidden window holds the resource context shared by every Window. All GL
+// objects are created and all rendering happens in that context; windows
+// only present finished images. The ImGui overlay reads its input from one
+// attached window and is drawn into whatever framebuffer is bound.
+class Platform : private NonCopyable {
+public:
+    Platform();
+    ~Platform();
+
+    explicit operator bool() const { return context; }
+
+    GLFWwindow* getContext() const { return context; }
+    void makeCurrent() const;
+
+    // The window must stay alive until detached.
+    void attachOverlay(GLFWwindow* window);
+    void detachOverlay();
+
+    // ImGui calls are only valid between beginFrame() and renderOverlay() of
+    // frames where the overlay is visible.
+    bool isOverlayVisible() const { return overlayWindow && overlayVisible; }
+
+    // Polls events and starts the overlay frame.
+    void beginFrame();
+    void renderOverlay();
+
+private:
+    GLFWwindow* context;
+    GLFWwindow* overlayWindow;
+    std::unique_ptr<ImGuiRenderer> imguiRenderer;
+    bool overlayVisible;
+    bool overlayKeyDown;
+};
+
+#endif
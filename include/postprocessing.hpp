@@ -0,0 +1,48 @@
+#ifndef POSTPROCESSING_HPP
+#define POSTPROCESSING_HPP
+
+#include <glad/gl.h>
+#include "framebuffer.hpp"
+#include "math/vector.hpp"
+#include "shader.hpp"
+#include "utils/noncopyable.hpp"
+
+// Turns the HDR scene color into the displayed image in a single compute
+// dispatch: tonemapping, color grading, sharpening and vignette are fused, and
+// the graded tile with a one texel apron is kept in shared memory for the
+// sharpening kernel. The HDR target is read once and the output written once,
+// instead of one fullscreen round trip per effect.
+//
+// Presenting upscales the image to the window with a bilinear filter followed
+// by a sharpening pass, for scenes rendered below the native resolution.
+class PostProcessing : private NonCopyable {
+public:
+    struct Settings {
+        float exposure = 1;
+        float contrast = 1;
+        float saturation = 1;
+        Vector3f tint{ 1, 1, 1 };
+        float vignette = 0.3f;
+        float sharpness = 0.2f;
+    };
+
+    PostProcessing();
+    ~PostProcessing();
+
+    explicit operator bool() const { return shader && upscaleShader; }
+
+    // The destination must be an RGBA8 texture of the given size. The caller
+    // issues the barrier before the destination is read.
+    void apply(GLuint source, GLuint destination, const Vector2i& size, const Settings& settings);
+
+    // Draws a texture over the whole target.
+    void present(GLuint texture, const Framebuffer& target, float sharpness);
+
+private:
+    Shader shader;
+    Shader upscaleShader;
+    GLuint vertexArray;
+    GLuint sampler;
+};
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef RENDERGRAPH_HPP
+#define RENDERGRAPH_HPP
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include <glad/gl.h>
+#include "gputimer.hpp"
+#include "math/vector.hpp"
+#include "utils/noncopyable.hpp"
+
+// Frame graph of render and compute passes.
+//
+// Every frame, passes are declared along with the textures and buffers they
+// read and write and how they access them. compile() then
+// - culls the passes that contribute neither to an output nor to a side effect,
+// - orders the remaining ones along their dependencies, running the passes
+//   that need no barrier first so that several consumers share one barrier,
+// - computes the glMemoryBarrier bits of each pass: only incoherent writes
+//   (image stores, storage buffers) followed by another access need one,
+// - maps transient resources onto pooled GL objects, so that transients with
+//   non-overlapping lifetimes and compatible descriptions share storage.
+//
+// GL cannot place several resources in the same memory, so aliasing happens
+// at the object level. Transients start out with undefined contents. Pooled
+// objects persist across frames and are released after a few unused frames.
+//
+// Every executed pass is timed on the GPU, and on the CPU for the time spent
+// issuing its commands, which is mostly driver overhead.
+class RenderGraph : private NonCopyable {
+public:
+    using Resource = int;
+
+    enum class Access {
+        Attachment, // Framebuffer color or depth
+        Sampled, // Texture fetches
+        Image, // Image load and store
+        Storage, // Shader storage buffer
+        Uniform,
+        Vertex, // Vertex or index buffer
+        Indirect, // Draw or dispatch parameters
+        Transfer // Copies, blits and clears
+    };
+
+    struct TextureDescription {
+        Vector2i size;
+        GLenum format;
+        int levelCount = 1;
+    };
+
+    struct Statistics {
+        int passCount = 0;
+        int culledPassCount = 0;
+        int barrierCount = 0;
+        int transientCount = 0;
+        int physicalCount = 0;
+        GLsizeiptr transientBytes = 0;
+        GLsizeiptr physicalBytes = 0;
+    };
+
+    struct PassTiming {
+        std::string name;
+        float milliseconds;
+        float cpuMilliseconds;
+    };
+
+    class PassBuilder {
+    public:
+        void read(Resource resource, Access access);
+        void write(Resource resource, Access access);
+
+        // Keeps the pass even if none of its writes is used, e.g. for queries
+        // or readbacks.
+        void setSideEffect();
+
+    private:
+        friend class RenderGraph;
+
+        PassBuilder(RenderGraph& graph, int pass);
+
+        RenderGraph& graph;
+        int pass;
+    };
+
+    using Setup = std::function<void(PassBuilder&)>;
+    using Execute = std::function<void(const RenderGraph&)>;
+
+    RenderGraph();
+    ~RenderGraph();
+
+    // Clears the passes and resources declared for the previous frame.
+    void reset();
+
+    Resource importTexture(const std::string& name, GLuint texture);
+    Resource importBuffer(const std::string& name, GLuint buffer);
+    Resource createTexture(const std::string& name, const TextureDescription& description);
+    Resource createBuffer(const std::string& name, GLsizeiptr size);
+
+    // Passes writing outputs, directly or through other passes, are kept.
+    void markOutput(Resource resource);
+
+    void addPass(const std::string& name, const Setup& setup, Execute execute);
+
+    void compile();
+    void execute();
+
+    // Only valid while executing.
+    GLuint getTexture(Resource resource) const;
+    GLuint getBuffer(Resource resource) const;
+
+    const Statistics& getStatistics() const { return statistics; }
+
+    // Passes executed last frame in order, with GPU timings a few frames old
+    // and CPU timings of last frame.
+    const std::vector<PassTiming>& getTimings() const { return timings; }
+
+private:
+    enum class Type {
+        Texture,
+        Buffer
+    };
+
+    struct ResourceNode {
+        std::string name;
+        Type type;
+        bool imported;
+        bool output;
+        TextureDescription texture;
+        GLsizeiptr size;
+        GLuint object;
+    };
+
+    struct Use {
+        Resource resource;
+        Access access;
+        bool write;
+    };
+
+    struct PassNode {
+        std::string name;
+        std::vector<Use> uses;
+        Execute execute;
+        bool sideEffect;
+        bool culled;
+        GLbitfield barriers;
+    };
+
+    struct PhysicalResource {
+        Type type;
+        TextureDescription texture;
+        GLsizeiptr size;
+        GLuint object;
+        int lastUsedFrame;
+        int busyUntil;
+    };
+
+    std::vector<ResourceNode> resources;
+    std::vector<PassNode> passes;
+    std::vector<int> order;
+    std::vector<PhysicalResource> pool;
+    std::map<std::string, GpuTimer> timers;
+    std::vector<PassTiming> timings;
+    int frame;
+    bool compiled;
+    Statistics statistics;
+
+    void cullPasses();
+    void orderPasses();
+    void allocateTransients();
+    void releaseUnused();
+};
+
+#endif
@@ -1,32 +1,177 @@
 #ifndef SHADER_HPP
 #define SHADER_HPP
 
+#include <array>
+#include <cstdint>
 #include <filesystem>
+#include <span>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 #include <glad/gl.h>
 #include "math/matrix.hpp"
+#include "math/vector.hpp"
 #include "utils/noncopyable.hpp"
 
+// Active uniforms are reflected once at link time into a table sorted by name
+// hash. Names are hashed at compile time and resolve to typed handles, and
+// values are cached so that unchanged uniforms are not sent again. Setting a
+// uniform neither allocates nor queries GL.
+//
+// Program binaries are cached in shadercache/, keyed by the hash of the
+// expanded sources and the driver strings, and compiled again when missing
+// or rejected. Linking only queues the binary; writeBinaries() does the disk
+// I/O, between frames.
+//
+// Parallel compilation only issues the compile and link commands, so that
+// the driver works on many programs at once, and isReady() polls them with
+// GL_KHR_parallel_shader_compile. Uniforms of a shader that is not ready are
+// ignored and it must not be bound.
 class Shader : private NonCopyable {
 public:
+    enum class Compilation {
+        Blocking,
+        Parallel
+    };
+
+    // Built implicitly from string literals.
+    class UniformName {
+    public:
+        consteval UniformName(const char* name)
+            : name{ name }
+            , hash{ hashName(name) }
+        {
+        }
+
+        const char* getName() const { return name; }
+        std::uint32_t getHash() const { return hash; }
+
+    private:
+        const char* name;
+        std::uint32_t hash;
+    };
+
+    // Valid for the lifetime of the shader it was obtained from. Unknown
+    // names and mismatching types give an invalid handle, which is ignored.
+    template <typename T>
+    class Uniform {
+    public:
+        Uniform()
+            : index{ -1 }
+        {
+        }
+
+        explicit operator bool() const { return index >= 0; }
+
+    private:
+        friend class Shader;
+
+        explicit Uniform(int index)
+            : index{ index }
+        {
+        }
+
+        int index;
+    };
+
     Shader();
+    Shader(Shader&& other) noexcept;
     ~Shader();
 
+    // The previous program is deleted once the GPU is done with it.
+    Shader& operator=(Shader&& other) noexcept;
+
+    // True while compiling, false once compilation failed.
     explicit operator bool() const { return program != 0; }
 
+    // Finishes setting the shader up once the driver is done with it.
+    bool isReady();
+
     void bind() const;
 
-    void setUniform(const std::string& name, const Matrix4f& m);
+    template <typename T>
+    Uniform<T> getUniform(UniformName name) const { return Uniform<T>{ findUniform(name, getUniformType<T>()) }; }
 
-    static Shader loadFromFile(const std::filesystem::path& vsFilename, const std::filesystem::path& fsFilename);
-    static Shader loadFromMemory(const std::string& vsSource, const std::string& fsSource);
+    void setUniform(Uniform<int> uniform, int i);
+    void setUniform(Uniform<float> uniform, float f);
+    void setUniform(Uniform<Vector2f> uniform, const Vector2f& v);
+    void setUniform(Uniform<Vector3f> uniform, const Vector3f& v);
+    void setUniform(Uniform<Matrix4f> uniform, const Matrix4f& m);
+
+    void setUniform(UniformName name, int i) { setUniform(getUniform<int>(name), i); }
+    void setUniform(UniformName name, float f) { setUniform(getUniform<float>(name), f); }
+    void setUniform(UniformName name, const Vector2f& v) { setUniform(getUniform<Vector2f>(name), v); }
+    void setUniform(UniformName name, const Vector3f& v) { setUniform(getUniform<Vector3f>(name), v); }
+    void setUniform(UniformName name, const Matrix4f& m) { setUniform(getUniform<Matrix4f>(name), m); }
+
+    static Shader loadFromFile(const std::filesystem::path& vsFilename, const std::filesystem::path& fsFilename, Compilation compilation = Compilation::Blocking);
+    static Shader loadFromFile(const std::filesystem::path& vsFilename, const std::filesystem::path& fsFilename, std::span<const std::string_view> defines, Compilation compilation = Compilation::Blocking);
+    static Shader loadFromFile(const std::filesystem::path& csFilename);
+    static Shader loadFromMemory(const std::string& vsSource, const std::string& fsSource, Compilation compilation = Compilation::Blocking);
+    static Shader loadFromMemory(const std::string& csSource);
+
+    // Defines go right after #version, which must come first.
+    static void injectDefines(std::string& source, std::span<const std::string_view> defines);
+
+    // Called once the context is current.
+    static void setupParallelCompilation(GLADloadfunc load);
+
+    // Writes the binaries of the programs linked since the last call. Needs
+    // no GL context.
+    static void writeBinaries();
 
 private:
+    struct UniformEntry {
+        std::uint32_t hash;
+        GLint location;
+        GLenum type;
+        bool cached;
+        std::array<float, 16> value;
+    };
+
     GLuint program;
+    std::array<GLuint, 2> stages;
+    std::filesystem::path cachePath;
+    bool ready;
+    std::vector<UniformEntry> uniforms;
+
+    Shader(GLuint program, const std::array<GLuint, 2>& stages, const std::filesystem::path& cachePath, Compilation compilation);
+
+    // FNV-1a.
+    static constexpr std::uint32_t hashName(std::string_view name)
+    {
+        std::uint32_t hash = 2166136261u;
+        for (char c : name)
+            hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+
+        return hash;
+    }
+
+    template <typename T>
+    static constexpr GLenum getUniformType()
+    {
+        if constexpr (std::is_same_v<T, int>)
+            return GL_INT;
+        else if constexpr (std::is_same_v<T, float>)
+            return GL_FLOAT;
+        else if constexpr (std::is_same_v<T, Vector2f>)
+            return GL_FLOAT_VEC2;
+        else if constexpr (std::is_same_v<T, Vector3f>)
+            return GL_FLOAT_VEC3;
+        else {
+            static_assert(std::is_same_v<T, Matrix4f>);
+            return GL_FLOAT_MAT4;
+        }
+    }
 
-    Shader(GLuint program);
+    void release();
+    void finishLinking();
+    void reflectUniforms();
+    int findUniform(UniformName name, GLenum type) const;
 
-    GLint getUniformLocation(const std::string& name) const;
+    // Returns false if the uniform already holds the value.
+    bool updateCache(int index, std::span<const float> value);
 };
 
 #endif
@@ -0,0 +1,87 @@
+#ifndef SHADERLIBRARY_HPP
+#define SHADERLIBRARY_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "shader.hpp"
+#include "utils/noncopyable.hpp"
+
+// Shaders reloaded when one of their source files changes.
+//
+// Includes are expanded here rather than by stb_include so that every
+// program records the files it was built from. A background thread watches
+// their directories with inotify, and update() recompiles the programs
+// depending on a changed file. A program is swapped in only once it links;
+// the previous one is kept otherwise. File contents are memoized until they
+// change, so an include shared by several programs is read once per change.
+//
+// Programs may declare feature keywords. Each combination in use is compiled
+// as a separate variant with a #define per enabled keyword right after
+// #version, so features are resolved by the preprocessor instead of branching
+// at run time. Variants are keyed by a bitmask, bit i for keyword i, and
+// compiled the first time they are asked for, so only the combinations
+// actually used are ever compiled.
+//
+// Watching is only available on Linux; elsewhere shaders load but never
+// reload.
+class ShaderLibrary : private NonCopyable {
+public:
+    ShaderLibrary();
+    ~ShaderLibrary();
+
+    // The shader is owned by the library and keeps its address across
+    // reloads. Reloads always compile blocking.
+    Shader& load(const std::filesystem::path& vsFilename, const std::filesystem::path& fsFilename, Shader::Compilation compilation = Shader::Compilation::Blocking);
+    Shader& load(const std::filesystem::path& csFilename);
+
+    // Returns the index of the program, nothing is compiled yet.
+    int loadVariants(const std::filesystem::path& vsFilename, const std::filesystem::path& fsFilename, std::span<const std::string_view> keywords, Shader::Compilation compilation = Shader::Compilation::Blocking);
+
+    // Compiles the variant when first asked for, with the compilation mode of
+    // the program; a parallel variant is not ready right away. Calling it
+    // early pre-warms the variant.
+    Shader& getVariant(int program, std::uint32_t features);
+
+    // Must be called on the GL thread, outside of a frame. Also writes the
+    // program binaries queued since the last call. Returns the number of
+    // programs reloaded.
+    int update();
+
+private:
+    struct Program {
+        std::vector<std::filesystem::path> sources;
+        std::vector<std::string> keywords;
+        Shader::Compilation compilation;
+        std::unordered_map<std::uint32_t, std::unique_ptr<Shader>> variants;
+        std::vector<std::filesystem::path> dependencies;
+    };
+
+    std::vector<Program> programs;
+    std::map<std::filesystem::path, std::string> files;
+
+    int inotifyDescriptor;
+    int stopDescriptor;
+    std::thread watcher;
+    std::mutex mutex;
+    std::map<int, std::filesystem::path> directories;
+    std::set<std::filesystem::path> changedFiles;
+
+    Shader compile(const Program& program, std::uint32_t features, Shader::Compilation compilation, std::vector<std::filesystem::path>& dependencies);
+    bool expand(const std::filesystem::path& filename, int depth, std::string& result, std::vector<std::filesystem::path>& dependencies);
+    const std::string* read(const std::filesystem::path& filename);
+    void addDependencies(Program& program, std::vector<std::filesystem::path> dependencies);
+    void watchDirectories(const std::vector<std::filesystem::path>& dependencies);
+    void watch();
+};
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef SOFTWARERENDERER_HPP
+#define SOFTWARERENDERER_HPP
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "lighting/clusteredlighting.hpp"
+#include "math/matrix.hpp"
+#include "math/vector.hpp"
+#include "mesh.hpp"
+#include "utils/noncopyable.hpp"
+#include "utils/threadpool.hpp"
+
+// CPU implementation of main.vs.glsl and main.fs.glsl, for machines without
+// a GPU.
+//
+// Draws are transformed, clipped against the near plane and binned into tiles
+// on the calling thread, then tiles are rasterized and shaded in parallel,
+// four pixels at a time. Every tile owns its pixels, so workers never share a
+// cache line of color or depth. Attributes are interpolated with perspective
+// correction and depth is tested with GL_LESS like the GL path. Lights are
+// culled per triangle against its view space bounds instead of per cluster.
+//
+// The image is the lit scene color clamped to RGBA8, before post-processing,
+// rows bottom to top like glReadPixels.
+class SoftwareRenderer : private NonCopyable {
+public:
+    static constexpr int TileWidth = 64;
+    static constexpr int TileHeight = 32;
+
+    struct Statistics {
+        int triangleCount = 0;
+        int binnedTriangleCount = 0;
+    };
+
+    // The width must be a multiple of 4.
+    SoftwareRenderer(ThreadPool& threadPool, const Vector2i& size);
+
+    const Vector2i& getSize() const { return size; }
+    const Statistics& getStatistics() const { return statistics; }
+
+    // Lights are in view space and must outlive rasterize().
+    void begin(const Matrix4f& projection, std::span<const ClusteredLighting::PointLight> lights, float ambient);
+    void draw(std::span<const Mesh::Vertex> vertices, std::span<const unsigned int> indices, const Matrix4f& model);
+    void rasterize();
+
+    // Packed RGBA8, red in the lowest byte.
+    std::span<const std::uint32_t> getColor() const { return color; }
+
+private:
+    struct Vertex {
+        Vector4f clip;
+        Vector3f color;
+        Vector2f texCoords;
+        Vector3f viewPosition;
+    };
+
+    struct Triangle {
+        Vector3f screen[3];
+        float inverseW[3];
+        Vector3f color[3];
+        Vector2f texCoords[3];
+        Vector3f viewPosition[3];
+        Vector3f normal;
+        Vector3f boundsMin;
+        Vector3f boundsMax;
+    };
+
+    ThreadPool& threadPool;
+    Vector2i size;
+    Vector2i tileCount;
+    Matrix4f projection;
+    std::span<const ClusteredLighting::PointLight> lights;
+    float ambient;
+    std::vector<std::uint32_t> color;
+    std::vector<float> depth;
+    std::vector<Vertex> transformed;
+    std::vector<Triangle> triangles;
+    std::vector<std::vector<int>> bins;
+    Statistics statistics;
+
+    void addTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2);
+    void rasterizeTile(int tile);
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef UNIFORMRING_HPP
+#define UNIFORMRING_HPP
+
+#include <cstddef>
+#include <glad/gl.h>
+#include "framering.hpp"
+#include "math/matrix.hpp"
+#include "utils/noncopyable.hpp"
+
+// Uniform blocks of the scene shaders, declared in shaders/uniforms.glsl.
+//
+// Blocks are copied into a persistently mapped ring, one region per frame in
+// flight, and bound with glBindBufferRange at the offset they were written
+// to. Setting the model of a draw is a memcpy and a range bind, the programs
+// themselves are not touched and may change between draws. Binding 0 is left
+// to MultiView.
+//
+// begin() and end() bracket the GL commands reading the blocks of a frame.
+// A frame that does not fit continues in a buffer twice as large.
+class UniformRing : private NonCopyable {
+public:
+    static constexpr GLuint FrameBinding = 1;
+    static constexpr GLuint DrawBinding = 2;
+
+    struct Statistics {
+        int growCount = 0;
+    };
+
+    // The capacity is in bytes per frame.
+    explicit UniformRing(int capacity = 1 << 20);
+    ~UniformRing();
+
+    const Statistics& getStatistics() const { return statistics; }
+
+    void begin();
+    void end();
+
+    void bindFrame(const Matrix4f& projection, float time);
+    void bindDraw(const Matrix4f& model);
+
+private:
+    // std140.
+    struct FrameUniforms {
+        Matrix4f projection;
+        float time;
+        float padding[3];
+    };
+
+    struct DrawUniforms {
+        Matrix4f model;
+    };
+
+    int capacity;
+    GLint alignment;
+    GLuint buffer;
+    std::byte* data;
+    FrameRing ring;
+    int offset;
+    Statistics statistics;
+
+    void bind(GLuint binding, const void* block, int size);
+    void createBuffer();
+};
+
+#endif
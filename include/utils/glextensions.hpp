@@ -0,0 +1,8 @@
+#ifndef UTILS_GLEXTENSIONS_HPP
+#define UTILS_GLEXTENSIONS_HPP
+
+// Extensions the generated loader knows nothing about. Needs a current
+// context.
+bool hasExtension(const char* name);
+
+#endif
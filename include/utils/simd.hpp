@@ -0,0 +1,100 @@
+#ifndef UTILS_SIMD_HPP
+#define UTILS_SIMD_HPP
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE2
+#include <emmintrin.h>
+#else
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#endif
+
+// Four packed floats. Comparisons return lane masks with all bits set where
+// the comparison holds, to be consumed by select() or moveMask().
+class Float4 {
+public:
+#ifdef SIMD_SSE2
+    __m128 v;
+
+    Float4() = default;
+    Float4(__m128 v) : v{ v } {}
+    Float4(float value) : v{ _mm_set1_ps(value) } {}
+    Float4(float x, float y, float z, float w) : v{ _mm_setr_ps(x, y, z, w) } {}
+
+    static Float4 load(const float* p) { return _mm_loadu_ps(p); }
+    void store(float* p) const { _mm_storeu_ps(p, v); }
+
+    friend Float4 operator+(Float4 a, Float4 b) { return _mm_add_ps(a.v, b.v); }
+    friend Float4 operator-(Float4 a, Float4 b) { return _mm_sub_ps(a.v, b.v); }
+    friend Float4 operator*(Float4 a, Float4 b) { return _mm_mul_ps(a.v, b.v); }
+    friend Float4 operator/(Float4 a, Float4 b) { return _mm_div_ps(a.v, b.v); }
+    friend Float4 operator&(Float4 a, Float4 b) { return _mm_and_ps(a.v, b.v); }
+    friend Float4 operator|(Float4 a, Float4 b) { return _mm_or_ps(a.v, b.v); }
+    friend Float4 operator<(Float4 a, Float4 b) { return _mm_cmplt_ps(a.v, b.v); }
+    friend Float4 operator<=(Float4 a, Float4 b) { return _mm_cmple_ps(a.v, b.v); }
+    friend Float4 operator>(Float4 a, Float4 b) { return _mm_cmpgt_ps(a.v, b.v); }
+    friend Float4 operator>=(Float4 a, Float4 b) { return _mm_cmpge_ps(a.v, b.v); }
+
+    friend Float4 min(Float4 a, Float4 b) { return _mm_min_ps(a.v, b.v); }
+    friend Float4 max(Float4 a, Float4 b) { return _mm_max_ps(a.v, b.v); }
+    friend Float4 sqrt(Float4 a) { return _mm_sqrt_ps(a.v); }
+    friend Float4 select(Float4 mask, Float4 a, Float4 b) { return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }
+    friend int moveMask(Float4 mask) { return _mm_movemask_ps(mask.v); }
+#else
+    std::array<float, 4> v;
+
+    Float4() = default;
+    Float4(float value) : v{ value, value, value, value } {}
+    Float4(float x, float y, float z, float w) : v{ x, y, z, w } {}
+
+    static Float4 load(const float* p) { return Float4{ p[0], p[1], p[2], p[3] }; }
+    void store(float* p) const { std::copy(v.begin(), v.end(), p); }
+
+    friend Float4 operator+(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x + y; }); }
+    friend Float4 operator-(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x - y; }); }
+    friend Float4 operator*(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x * y; }); }
+    friend Float4 operator/(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x / y; }); }
+    friend Float4 operator&(Float4 a, Float4 b) { return bitwise(a, b, [](std::uint32_t x, std::uint32_t y) { return x & y; }); }
+    friend Float4 operator|(Float4 a, Float4 b) { return bitwise(a, b, [](std::uint32_t x, std::uint32_t y) { return x | y; }); }
+    friend Float4 operator<(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return mask(x < y); }); }
+    friend Float4 operator<=(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return mask(x <= y); }); }
+    friend Float4 operator>(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return mask(x > y); }); }
+    friend Float4 operator>=(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return mask(x >= y); }); }
+
+    friend Float4 min(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return y < x ? y : x; }); }
+    friend Float4 max(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x < y ? y : x; }); }
+    friend Float4 sqrt(Float4 a) { return Float4{ std::sqrt(a.v[0]), std::sqrt(a.v[1]), std::sqrt(a.v[2]), std::sqrt(a.v[3]) }; }
+    friend Float4 select(Float4 mask, Float4 a, Float4 b) { return (mask & a) | bitwise(mask, b, [](std::uint32_t x, std::uint32_t y) { return ~x & y; }); }
+
+    friend int moveMask(Float4 mask)
+    {
+        int result = 0;
+        for (int i = 0; i < 4; ++i)
+            result |= static_cast<int>(std::bit_cast<std::uint32_t>(mask.v[i]) >> 31) << i;
+
+        return result;
+    }
+
+private:
+    static float mask(bool b) { return std::bit_cast<float>(b ? ~std::uint32_t{ 0 } : std::uint32_t{ 0 }); }
+
+    template <typename Function>
+    static Float4 apply(Float4 a, Float4 b, Function function)
+    {
+        return Float4{ function(a.v[0], b.v[0]), function(a.v[1], b.v[1]), function(a.v[2], b.v[2]), function(a.v[3], b.v[3]) };
+    }
+
+    template <typename Function>
+    static Float4 bitwise(Float4 a, Float4 b, Function function)
+    {
+        return apply(a, b, [&](float x, float y) {
+            return std::bit_cast<float>(function(std::bit_cast<std::uint32_t>(x), std::bit_cast<std::uint32_t>(y)));
+        });
+    }
+#endif
+};
+
+#endif
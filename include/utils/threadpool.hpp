@@ -0,0 +1,41 @@
+#ifndef UTILS_THREADPOOL_HPP
+#define UTILS_THREADPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "utils/noncopyable.hpp"
+
+class ThreadPool : private NonCopyable {
+public:
+    explicit ThreadPool(int threadCount = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    // Worker threads plus the calling thread, which takes part in every batch.
+    int getThreadCount() const { return static_cast<int>(workers.size()) + 1; }
+
+    // Calls function(i) for every i in [0, count) and returns once all calls
+    // have completed. Batches are serialized; do not call from inside a batch.
+    void parallelFor(int count, const std::function<void(int)>& function);
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex batchMutex;
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+    const std::function<void(int)>* function;
+    int count;
+    std::atomic<int> next;
+    int activeWorkers;
+    unsigned int generation;
+    bool stopping;
+
+    void run();
+    void work();
+};
+
+#endif
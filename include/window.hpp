@@ -2,14 +2,24 @@
 #define WINDOW_HPP
 
 #include <string>
+#include <glad/gl.h>
+#include "framebuffer.hpp"
 #include "math/vector.hpp"
+#include "platform.hpp"
 #include "utils/noncopyable.hpp"
 
 struct GLFWwindow;
 
+// A window presenting images rendered in the platform resource context.
+//
+// Its context shares every object of the resource context and only owns the
+// framebuffer object used to blit them. Only the primary window waits for
+// vertical sync, so that presenting to several windows costs a single wait:
+// present the others first.
 class Window : private NonCopyable {
 public:
-    Window(const std::string& title, const Vector2i& size);
+    // The primary window receives the overlay input.
+    Window(Platform& platform, const std::string& title, const Vector2i& size, bool primary);
     ~Window();
 
     explicit operator bool() const { return window; }
@@ -17,11 +27,17 @@ public:
     bool shouldClose() const;
     Vector2i getSize() const;
 
-    void beginFrame();
-    void endFrame();
+    // Called with the resource context current, which it leaves current. The
+    // image must be complete once the fence is signaled; one fence may cover
+    // the images of every window. It is scaled to fit the window, keeping its
+    // aspect ratio, and the buffers are swapped right away.
+    void present(const Framebuffer& image, GLsync fence);
 
 private:
+    Platform& platform;
     GLFWwindow* window;
+    bool primary;
+    GLuint framebuffer;
 };
 
 #endif
@@ -0,0 +1,25 @@
+#version 460 core
+#ifdef MULTI_VIEW
+#extension GL_ARB_shader_viewport_layer_array : enable
+#endif
+
+#include "multiview.glsl"
+
+uniform mat4 model;
+uniform mat4 viewProjection;
+uniform vec3 boundsMin;
+uniform vec3 boundsMax;
+
+void main()
+{
+    // Cube as a 14 vertex triangle strip.
+    const uint bit = 1u << gl_VertexID;
+    const vec3 corner = vec3((0x287au & bit) != 0u, (0x02afu & bit) != 0u, (0x31e3u & bit) != 0u);
+    const vec4 position = model * vec4(mix(boundsMin, boundsMax, corner), 1.0);
+
+#ifdef MULTI_VIEW
+    gl_Position = projectToView(position);
+#else
+    gl_Position = viewProjection * position;
+#endif
+}
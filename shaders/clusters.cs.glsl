@@ -0,0 +1,64 @@
+#version 460 core
+
+#include "clusters.glsl"
+
+layout (local_size_x = 64) in;
+
+uniform int lightCount;
+uniform float tanHalfFovY;
+uniform float aspect;
+uniform float zNear;
+uniform float zFar;
+
+shared PointLight sharedLights[64];
+
+float squaredDistanceToBox(vec3 p, vec3 boxMin, vec3 boxMax)
+{
+    const vec3 d = max(max(boxMin - p, p - boxMax), 0.0);
+
+    return dot(d, d);
+}
+
+void main()
+{
+    const uint index = gl_GlobalInvocationID.x;
+    const uvec3 cluster = uvec3(
+        index % clusterCount.x,
+        index / clusterCount.x % clusterCount.y,
+        index / (clusterCount.x * clusterCount.y));
+
+    // View space bounds of the froxel; the camera looks down -z.
+    const vec2 ndcMin = vec2(cluster.xy) / vec2(clusterCount.xy) * 2.0 - 1.0;
+    const vec2 ndcMax = vec2(cluster.xy + 1) / vec2(clusterCount.xy) * 2.0 - 1.0;
+    const float near = getSliceDepth(cluster.z, zNear, zFar);
+    const float far = getSliceDepth(cluster.z + 1, zNear, zFar);
+    const vec2 scale = vec2(aspect * tanHalfFovY, tanHalfFovY);
+
+    const vec2 xyMin = min(ndcMin * scale * near, ndcMin * scale * far);
+    const vec2 xyMax = max(ndcMax * scale * near, ndcMax * scale * far);
+    const vec3 boxMin = vec3(xyMin, -far);
+    const vec3 boxMax = vec3(xyMax, -near);
+
+    uint count = 0;
+    const uint base = index * maxLightsPerCluster;
+
+    // Lights are streamed through shared memory one group-sized batch at a time.
+    for (int first = 0; first < lightCount; first += 64) {
+        const int i = first + int(gl_LocalInvocationIndex);
+        if (i < lightCount)
+            sharedLights[gl_LocalInvocationIndex] = lights[i];
+
+        barrier();
+
+        const int batchSize = min(64, lightCount - first);
+        for (int j = 0; j < batchSize && count < maxLightsPerCluster; ++j) {
+            const PointLight light = sharedLights[j];
+            if (squaredDistanceToBox(light.position, boxMin, boxMax) <= light.radius * light.radius)
+                clusterLightIndices[base + count++] = first + j;
+        }
+
+        barrier();
+    }
+
+    clusterLightCounts[index] = count;
+}
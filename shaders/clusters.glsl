@@ -0,0 +1,35 @@
+// Shared between the light binning pass and the fragment shader. Must match
+// the constants in ClusteredLighting.
+
+const uvec3 clusterCount = uvec3(16, 9, 24);
+const uint maxLightsPerCluster = 128;
+
+struct PointLight {
+    vec3 position;
+    float radius;
+    vec3 color;
+    float intensity;
+};
+
+layout (std430, binding = 5) readonly buffer Lights { PointLight lights[]; };
+layout (std430, binding = 6) buffer ClusterLightCounts { uint clusterLightCounts[]; };
+layout (std430, binding = 7) buffer ClusterLightIndices { uint clusterLightIndices[]; };
+
+uint getClusterIndex(uvec3 cluster)
+{
+    return (cluster.z * clusterCount.y + cluster.y) * clusterCount.x + cluster.x;
+}
+
+// Depth slices are distributed exponentially between zNear and zFar so that
+// froxels stay roughly cubic.
+float getSliceDepth(uint slice, float zNear, float zFar)
+{
+    return zNear * pow(zFar / zNear, float(slice) / float(clusterCount.z));
+}
+
+uint getSlice(float depth, float zNear, float zFar)
+{
+    const float slice = log(depth / zNear) / log(zFar / zNear) * float(clusterCount.z);
+
+    return uint(clamp(slice, 0.0, float(clusterCount.z - 1)));
+}
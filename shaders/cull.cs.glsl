@@ -0,0 +1,137 @@
+#version 460 core
+
+layout (local_size_x = 64) in;
+
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout (std430, binding = 0) readonly buffer Models { mat4 models[]; };
+layout (std430, binding = 1) buffer Visibility { uint visibility[]; };
+layout (std430, binding = 2) writeonly buffer Instances { uint instances[]; };
+layout (std430, binding = 3) buffer Counters {
+    DrawCommand commands[2];
+    uint frustumCulledCount;
+    uint occlusionCulledCount;
+};
+
+layout (binding = 0) uniform sampler2D hiz;
+
+uniform int instanceCount;
+uniform int phase;
+uniform int occlusionCulling;
+uniform int viewCount;
+uniform mat4 viewProjection;
+uniform vec3 boundsMin;
+uniform vec3 boundsMax;
+uniform vec2 hizSize;
+uniform int hizLevelCount;
+
+vec4 corners[8];
+
+void transformCorners(mat4 mvp)
+{
+    for (int i = 0; i < 8; ++i)
+        corners[i] = mvp * vec4(mix(boundsMin, boundsMax, vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1)), 1.0);
+}
+
+bool isOutsideFrustum()
+{
+    // A box is culled only if all its corners lie outside the same clip plane.
+    for (int plane = 0; plane < 6; ++plane) {
+        const int axis = plane / 2;
+        const float sign = plane % 2 == 0 ? 1.0 : -1.0;
+
+        bool outside = true;
+        for (int i = 0; i < 8 && outside; ++i)
+            outside = sign * corners[i][axis] > corners[i].w;
+
+        if (outside)
+            return true;
+    }
+
+    return false;
+}
+
+bool isOccluded()
+{
+    vec3 ndcMin = vec3(1.0);
+    vec3 ndcMax = vec3(-1.0);
+
+    for (int i = 0; i < 8; ++i) {
+        // Boxes crossing the near plane have no meaningful screen rectangle.
+        if (corners[i].w <= 0.0)
+            return false;
+
+        const vec3 ndc = corners[i].xyz / corners[i].w;
+        ndcMin = min(ndcMin, ndc);
+        ndcMax = max(ndcMax, ndc);
+    }
+
+    const vec2 uvMin = clamp(0.5 * ndcMin.xy + 0.5, 0.0, 1.0);
+    const vec2 uvMax = clamp(0.5 * ndcMax.xy + 0.5, 0.0, 1.0);
+
+    // Pick the level where the rectangle spans at most 2x2 texels.
+    const vec2 extent = (uvMax - uvMin) * hizSize;
+    const int level = int(clamp(ceil(log2(max(max(extent.x, extent.y), 1.0))), 0.0, float(hizLevelCount - 1)));
+
+    // Work in level 0 texels and shift down: levels are max(size >> level, 1)
+    // wide and the pyramid folds odd rows and columns into the last texel, so
+    // normalized coordinates would miss it whenever the size is not a power of
+    // two.
+    const ivec2 size = ivec2(hizSize);
+    const ivec2 last = max(size >> level, 1) - 1;
+    const ivec2 texelMin = min(min(ivec2(uvMin * hizSize), size - 1) >> level, last);
+    const ivec2 texelMax = min(min(ivec2(uvMax * hizSize), size - 1) >> level, last);
+
+    float farthest = 0.0;
+    for (int y = texelMin.y; y <= texelMax.y; ++y) {
+        for (int x = texelMin.x; x <= texelMax.x; ++x)
+            farthest = max(farthest, texelFetch(hiz, ivec2(x, y), level).r);
+    }
+
+    return 0.5 * ndcMin.z + 0.5 > farthest;
+}
+
+void append(int phase, uint instance)
+{
+    // Every visible instance is drawn once per view.
+    const uint slot = atomicAdd(commands[phase].instanceCount, viewCount) / viewCount;
+    instances[commands[phase].baseInstance + slot] = instance;
+}
+
+void main()
+{
+    const uint i = gl_GlobalInvocationID.x;
+    if (i >= instanceCount)
+        return;
+
+    transformCorners(viewProjection * models[i]);
+
+    // Early phase: redraw whatever was visible last frame.
+    if (phase == 0) {
+        if (visibility[i] != 0 && !isOutsideFrustum())
+            append(0, i);
+        return;
+    }
+
+    // Late phase: test everything against the fresh pyramid and draw what the
+    // early phase missed.
+    bool visible = true;
+    if (isOutsideFrustum()) {
+        visible = false;
+        atomicAdd(frustumCulledCount, 1);
+    } else if (occlusionCulling != 0 && isOccluded()) {
+        visible = false;
+        atomicAdd(occlusionCulledCount, 1);
+    }
+
+    if (visible && visibility[i] == 0)
+        append(1, i);
+
+    visibility[i] = visible ? 1 : 0;
+}
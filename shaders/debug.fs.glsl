@@ -0,0 +1,10 @@
+#version 460 core
+
+in vec4 color;
+
+out vec4 fragColor;
+
+void main()
+{
+    fragColor = color;
+}
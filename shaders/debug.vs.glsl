@@ -0,0 +1,24 @@
+#version 460 core
+#ifdef MULTI_VIEW
+#extension GL_ARB_shader_viewport_layer_array : enable
+#endif
+
+#include "multiview.glsl"
+
+layout (location = 0) in vec3 inPosition;
+layout (location = 1) in vec4 inColor;
+
+uniform mat4 viewProjection;
+
+out vec4 color;
+
+void main()
+{
+    color = inColor;
+
+#ifdef MULTI_VIEW
+    gl_Position = projectToView(vec4(inPosition, 1.0));
+#else
+    gl_Position = viewProjection * vec4(inPosition, 1.0);
+#endif
+}
@@ -0,0 +1,23 @@
+#version 460 core
+#ifdef MULTI_VIEW
+#extension GL_ARB_shader_viewport_layer_array : enable
+#endif
+
+#include "multiview.glsl"
+#include "uniforms.glsl"
+
+layout (location = 0) in vec3 inPosition;
+
+// Must match main.vs.glsl bit for bit so the color pass can use GL_EQUAL.
+invariant gl_Position;
+
+void main()
+{
+    const vec4 position = draw.model * vec4(inPosition, 1.0);
+
+#ifdef MULTI_VIEW
+    gl_Position = projectToView(position);
+#else
+    gl_Position = projection * position;
+#endif
+}
@@ -0,0 +1,11 @@
+#version 460 core
+
+out vec2 texCoords;
+
+void main()
+{
+    // Triangle covering the viewport.
+    texCoords = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0;
+
+    gl_Position = vec4(texCoords * 2.0 - 1.0, 0.0, 1.0);
+}
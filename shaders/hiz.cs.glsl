@@ -0,0 +1,46 @@
+#version 460 core
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (binding = 0) uniform sampler2D depth;
+layout (binding = 0, r32f) uniform readonly image2D source;
+layout (binding = 1, r32f) uniform writeonly image2D destination;
+
+uniform int level;
+uniform vec2 sourceSize;
+
+float load(ivec2 p)
+{
+    p = min(p, ivec2(sourceSize) - 1);
+
+    return level == 0 ? texelFetch(depth, p, 0).r : imageLoad(source, p).r;
+}
+
+void main()
+{
+    const ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(p, imageSize(destination))))
+        return;
+
+    if (level == 0) {
+        imageStore(destination, p, vec4(load(p)));
+        return;
+    }
+
+    // Odd source dimensions leave an extra row/column that must be folded into
+    // the last texel, otherwise the pyramid is not conservative.
+    const ivec2 s = 2 * p;
+    const bvec2 odd = bvec2(int(sourceSize.x) % 2 == 1, int(sourceSize.y) % 2 == 1);
+    const ivec2 last = imageSize(destination) - 1;
+
+    float z = max(max(load(s), load(s + ivec2(1, 0))), max(load(s + ivec2(0, 1)), load(s + ivec2(1, 1))));
+
+    if (odd.x && p.x == last.x)
+        z = max(z, max(load(s + ivec2(2, 0)), load(s + ivec2(2, 1))));
+    if (odd.y && p.y == last.y)
+        z = max(z, max(load(s + ivec2(0, 2)), load(s + ivec2(1, 2))));
+    if (odd.x && odd.y && p == last)
+        z = max(z, load(s + ivec2(2, 2)));
+
+    imageStore(destination, p, vec4(z));
+}
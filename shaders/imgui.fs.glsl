@@ -0,0 +1,13 @@
+#version 460 core
+
+layout (binding = 0) uniform sampler2D image;
+
+in vec2 texCoords;
+in vec4 color;
+
+out vec4 fragColor;
+
+void main()
+{
+    fragColor = color * texture(image, texCoords);
+}
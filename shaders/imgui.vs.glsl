@@ -0,0 +1,20 @@
+#version 460 core
+
+layout (location = 0) in vec2 inPosition;
+layout (location = 1) in vec2 inTexCoords;
+layout (location = 2) in vec4 inColor;
+
+// Maps display coordinates, y down, to clip space.
+uniform vec2 scale;
+uniform vec2 translate;
+
+out vec2 texCoords;
+out vec4 color;
+
+void main()
+{
+    texCoords = inTexCoords;
+    color = inColor;
+
+    gl_Position = vec4(inPosition * scale + translate, 0.0, 1.0);
+}
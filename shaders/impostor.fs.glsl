@@ -0,0 +1,36 @@
+#version 460 core
+
+#include "lighting.glsl"
+
+in vec2 atlasCoords;
+in vec3 viewPosition;
+flat in mat3 normalMatrix;
+flat in float fade;
+
+layout (binding = 0) uniform sampler2D albedoAtlas;
+layout (binding = 1) uniform sampler2D normalAtlas;
+
+out vec4 fragColor;
+
+// 4x4 ordered dither, fades without blending or sorting.
+float getDitherThreshold()
+{
+    const float bayer[16] = float[](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0, 3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+    const uvec2 p = uvec2(gl_FragCoord.xy) & 3u;
+
+    return (bayer[p.y * 4u + p.x] + 0.5) / 16.0;
+}
+
+void main()
+{
+    if (fade <= getDitherThreshold())
+        discard;
+
+    const vec4 albedo = texture(albedoAtlas, atlasCoords);
+    if (albedo.a < 0.5)
+        discard;
+
+    const vec3 normal = normalize(normalMatrix * (texture(normalAtlas, atlasCoords).xyz * 2.0 - 1.0));
+
+    fragColor = vec4(computeLighting(albedo.rgb, normal, viewPosition), 1.0);
+}
@@ -0,0 +1,45 @@
+// Shared between the impostor bake and draw. Must match the layout in
+// Impostor: frame (i, j) of the atlas holds the view from the direction at the
+// center of cell (i, j) of an octahedral map over the unit sphere.
+
+vec2 signNotZero(vec2 v)
+{
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 encodeOctahedral(vec3 direction)
+{
+    const vec2 p = direction.xy / (abs(direction.x) + abs(direction.y) + abs(direction.z));
+
+    return direction.z >= 0.0 ? p : (1.0 - abs(p.yx)) * signNotZero(p);
+}
+
+vec3 decodeOctahedral(vec2 p)
+{
+    vec3 direction = vec3(p, 1.0 - abs(p.x) - abs(p.y));
+    if (direction.z < 0.0)
+        direction.xy = (1.0 - abs(direction.yx)) * signNotZero(direction.xy);
+
+    return normalize(direction);
+}
+
+ivec2 getFrame(vec3 direction, int frameCount)
+{
+    const ivec2 frame = ivec2((encodeOctahedral(direction) * 0.5 + 0.5) * float(frameCount));
+
+    return clamp(frame, ivec2(0), ivec2(frameCount - 1));
+}
+
+vec3 getFrameDirection(ivec2 frame, int frameCount)
+{
+    return decodeOctahedral((vec2(frame) + 0.5) / float(frameCount) * 2.0 - 1.0);
+}
+
+// Right-handed basis of the frame image, looking down -direction.
+void getFrameBasis(vec3 direction, out vec3 right, out vec3 up)
+{
+    const vec3 reference = abs(direction.y) < 0.999 ? vec3(0.0, 1.0, 0.0) : vec3(0.0, 0.0, 1.0);
+
+    right = normalize(cross(reference, direction));
+    up = cross(direction, right);
+}
@@ -0,0 +1,57 @@
+#version 460 core
+#ifdef MULTI_VIEW
+#extension GL_ARB_shader_viewport_layer_array : enable
+#endif
+
+#include "impostor.glsl"
+#include "multiview.glsl"
+#include "uniforms.glsl"
+
+struct ImpostorInstance {
+    mat4 model;
+    float fade;
+};
+
+layout (std430, binding = 11) readonly buffer ImpostorInstances { ImpostorInstance impostors[]; };
+
+uniform vec3 center;
+uniform float radius;
+uniform int frameCount;
+
+out vec2 atlasCoords;
+out vec3 viewPosition;
+flat out mat3 normalMatrix;
+flat out float fade;
+
+void main()
+{
+    const ImpostorInstance impostor = impostors[getInstance()];
+    const mat3 inverseModel = inverse(mat3(impostor.model));
+
+    // The camera sits at the origin of view space, which every view shares.
+    const vec3 viewCenter = (impostor.model * vec4(center, 1.0)).xyz;
+    const ivec2 frame = getFrame(normalize(inverseModel * -viewCenter), frameCount);
+
+    const vec3 direction = getFrameDirection(frame, frameCount);
+    vec3 right;
+    vec3 up;
+    getFrameBasis(direction, right, up);
+
+    // Pushed to the front of the bounding sphere so that the quad covers the
+    // mesh it fades in over.
+    const vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+    const vec3 objectPosition = center + radius * (corner.x * right + corner.y * up + direction);
+
+    const vec4 position = impostor.model * vec4(objectPosition, 1.0);
+    viewPosition = position.xyz;
+
+    atlasCoords = (vec2(frame) + 0.5 * corner + 0.5) / float(frameCount);
+    normalMatrix = transpose(inverseModel);
+    fade = impostor.fade;
+
+#ifdef MULTI_VIEW
+    gl_Position = projectToView(position);
+#else
+    gl_Position = projection * position;
+#endif
+}
@@ -0,0 +1,16 @@
+#version 460 core
+
+in vec3 color;
+in vec2 texCoords;
+in vec3 objectPosition;
+
+layout (location = 0) out vec4 albedo;
+layout (location = 1) out vec4 normal;
+
+void main()
+{
+    const float multiplier = texCoords.x > 0.05 && texCoords.x < 0.95 && texCoords.y > 0.05 && texCoords.y < 0.95 ? 1.0 : 0.2;
+
+    albedo = vec4(multiplier * color, 1.0);
+    normal = vec4(normalize(cross(dFdx(objectPosition), dFdy(objectPosition))) * 0.5 + 0.5, 1.0);
+}
@@ -0,0 +1,33 @@
+#version 460 core
+
+#include "impostor.glsl"
+
+layout (location = 0) in vec3 inPosition;
+layout (location = 1) in vec3 inColor;
+layout (location = 2) in vec2 inTexCoords;
+
+uniform vec3 center;
+uniform float radius;
+uniform int frameIndex;
+uniform int frameCount;
+
+out vec3 color;
+out vec2 texCoords;
+out vec3 objectPosition;
+
+void main()
+{
+    color = inColor;
+    texCoords = inTexCoords;
+    objectPosition = inPosition;
+
+    const vec3 direction = getFrameDirection(ivec2(frameIndex % frameCount, frameIndex / frameCount), frameCount);
+    vec3 right;
+    vec3 up;
+    getFrameBasis(direction, right, up);
+
+    // Orthographic, fitted to the bounding sphere.
+    const vec3 offset = (inPosition - center) / radius;
+
+    gl_Position = vec4(dot(offset, right), dot(offset, up), -dot(offset, direction), 1.0);
+}
@@ -0,0 +1,37 @@
+#version 460 core
+#ifdef MULTI_VIEW
+#extension GL_ARB_shader_viewport_layer_array : enable
+#endif
+
+#include "multiview.glsl"
+#include "uniforms.glsl"
+
+layout (location = 0) in vec3 inPosition;
+layout (location = 1) in vec3 inColor;
+layout (location = 2) in vec2 inTexCoords;
+
+layout (std430, binding = 0) readonly buffer Models { mat4 models[]; };
+layout (std430, binding = 2) readonly buffer Instances { uint instances[]; };
+
+out vec3 color;
+out vec2 texCoords;
+out vec3 viewPosition;
+
+invariant gl_Position;
+
+void main()
+{
+    const mat4 model = models[instances[gl_BaseInstance + getInstance()]];
+
+    color = inColor;
+    texCoords = inTexCoords;
+
+    const vec4 position = model * vec4(inPosition, 1.0);
+    viewPosition = position.xyz;
+
+#ifdef MULTI_VIEW
+    gl_Position = projectToView(position);
+#else
+    gl_Position = projection * position;
+#endif
+}
@@ -0,0 +1,40 @@
+// Clustered point light shading, shared by the forward fragment shaders.
+
+#include "clusters.glsl"
+
+uniform float ambient;
+uniform float zNear;
+uniform float zFar;
+uniform vec2 tanHalfFov;
+
+vec3 computeLighting(vec3 albedo, vec3 normal, vec3 viewPosition)
+{
+    // Froxels are found from the view position rather than gl_FragCoord, so
+    // that every view inside the clustered frustum can be shaded.
+    const vec2 ndc = viewPosition.xy / (-viewPosition.z * tanHalfFov);
+    const vec2 tile = clamp((0.5 * ndc + 0.5) * vec2(clusterCount.xy), vec2(0.0), vec2(clusterCount.xy - 1));
+    const uvec3 cluster = uvec3(uvec2(tile), getSlice(-viewPosition.z, zNear, zFar));
+    const uint index = getClusterIndex(cluster);
+    const uint count = clusterLightCounts[index];
+
+    vec3 result = ambient * albedo;
+
+    for (uint i = 0; i < count; ++i) {
+        const PointLight light = lights[clusterLightIndices[index * maxLightsPerCluster + i]];
+
+        const vec3 toLight = light.position - viewPosition;
+        const float distanceSquared = dot(toLight, toLight);
+        if (distanceSquared >= light.radius * light.radius)
+            continue;
+
+        // Inverse square falloff windowed to reach zero at the light radius.
+        const float ratio = distanceSquared / (light.radius * light.radius);
+        const float window = (1.0 - ratio * ratio) * (1.0 - ratio * ratio);
+        const float attenuation = window / (distanceSquared + 1.0);
+        const float diffuse = max(dot(normal, toLight * inversesqrt(distanceSquared)), 0.0);
+
+        result += light.intensity * attenuation * diffuse * light.color * albedo;
+    }
+
+    return result;
+}
@@ -1,13 +1,24 @@
 #version 460 core
 
+#include "lighting.glsl"
+
 in vec3 color;
 in vec2 texCoords;
+in vec3 viewPosition;
 
 out vec4 fragColor;
 
 void main()
 {
+    // Compiled as a separate variant rather than toggled by a uniform.
+#ifdef FACE_BORDERS
     const float multiplier = texCoords.x > 0.05 && texCoords.x < 0.95 && texCoords.y > 0.05 && texCoords.y < 0.95 ? 1.0 : 0.2;
+#else
+    const float multiplier = 1.0;
+#endif
+
+    // Meshes carry no normals; faces are flat so derivatives are enough.
+    const vec3 normal = normalize(cross(dFdx(viewPosition), dFdy(viewPosition)));
 
-    fragColor = vec4(multiplier * color, 1.0);
+    fragColor = vec4(computeLighting(multiplier * color, normal, viewPosition), 1.0);
 }
@@ -1,19 +1,32 @@
 #version 460 core
+#ifdef MULTI_VIEW
+#extension GL_ARB_shader_viewport_layer_array : enable
+#endif
+
+#include "multiview.glsl"
+#include "uniforms.glsl"
 
 layout (location = 0) in vec3 inPosition;
 layout (location = 1) in vec3 inColor;
 layout (location = 2) in vec2 inTexCoords;
 
-uniform mat4 projection;
-uniform mat4 model;
-
 out vec3 color;
 out vec2 texCoords;
+out vec3 viewPosition;
+
+invariant gl_Position;
 
 void main()
 {
     color = inColor;
     texCoords = inTexCoords;
 
-    gl_Position = projection * model * vec4(inPosition, 1.0);
+    const vec4 position = draw.model * vec4(inPosition, 1.0);
+    viewPosition = position.xyz;
+
+#ifdef MULTI_VIEW
+    gl_Position = projectToView(position);
+#else
+    gl_Position = projection * position;
+#endif
 }
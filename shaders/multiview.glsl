@@ -0,0 +1,42 @@
+// Views rendered in a single pass, see MultiView.
+//
+// With MULTI_VIEW defined, instances are fanned out per view: draws multiply
+// their instance count by the view count, getInstance() gives the instance
+// drawn and projectToView() the clip position in the view of the current
+// instance. The shaders including this file must then enable
+// GL_ARB_shader_viewport_layer_array right after #version. Without it,
+// getInstance() is gl_InstanceID.
+
+#ifdef MULTI_VIEW
+
+const int maxViewCount = 4;
+
+layout (std140, binding = 0) uniform Views {
+    mat4 viewProjections[maxViewCount];
+    int viewCount;
+};
+
+int getInstance()
+{
+    return gl_InstanceID / viewCount;
+}
+
+vec4 projectToView(vec4 position)
+{
+    const int view = gl_InstanceID % viewCount;
+
+#ifdef GL_ARB_shader_viewport_layer_array
+    gl_ViewportIndex = view;
+#endif
+
+    return viewProjections[view] * position;
+}
+
+#else
+
+int getInstance()
+{
+    return gl_InstanceID;
+}
+
+#endif
@@ -0,0 +1,71 @@
+#version 460 core
+
+// Must match TileSize in PostProcessing.
+layout (local_size_x = 16, local_size_y = 16) in;
+
+layout (binding = 0) uniform sampler2D source;
+layout (binding = 0, rgba8) uniform writeonly image2D destination;
+
+uniform float exposure;
+uniform float contrast;
+uniform float saturation;
+uniform vec3 tint;
+uniform float vignette;
+uniform float sharpness;
+
+const int tileSize = 16;
+const int apronSize = tileSize + 2;
+
+shared vec3 tile[apronSize][apronSize];
+
+// Narkowicz's fit of the ACES filmic curve.
+vec3 tonemap(vec3 x)
+{
+    return clamp(x * (2.51 * x + 0.03) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);
+}
+
+vec3 grade(vec3 color)
+{
+    color *= tint;
+
+    const float luminance = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    color = mix(vec3(luminance), color, saturation);
+    color = (color - 0.5) * contrast + 0.5;
+
+    return clamp(color, 0.0, 1.0);
+}
+
+vec3 load(ivec2 p)
+{
+    p = clamp(p, ivec2(0), textureSize(source, 0) - 1);
+
+    return grade(tonemap(exposure * texelFetch(source, p, 0).rgb));
+}
+
+void main()
+{
+    // Every texel of the tile and its apron is tonemapped and graded once.
+    const ivec2 origin = ivec2(gl_WorkGroupID.xy) * tileSize - 1;
+    for (int i = int(gl_LocalInvocationIndex); i < apronSize * apronSize; i += tileSize * tileSize) {
+        const ivec2 t = ivec2(i % apronSize, i / apronSize);
+        tile[t.y][t.x] = load(origin + t);
+    }
+
+    barrier();
+
+    const ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    const ivec2 size = imageSize(destination);
+    if (any(greaterThanEqual(p, size)))
+        return;
+
+    // Unsharp mask with a cross kernel.
+    const ivec2 t = ivec2(gl_LocalInvocationID.xy) + 1;
+    const vec3 center = tile[t.y][t.x];
+    const vec3 neighbors = tile[t.y - 1][t.x] + tile[t.y + 1][t.x] + tile[t.y][t.x - 1] + tile[t.y][t.x + 1];
+    vec3 color = clamp(center + sharpness * (4.0 * center - neighbors), 0.0, 1.0);
+
+    const vec2 offset = (vec2(p) + 0.5) / vec2(size) - 0.5;
+    color *= 1.0 - vignette * 2.0 * dot(offset, offset);
+
+    imageStore(destination, p, vec4(color, 1.0));
+}
@@ -0,0 +1,50 @@
+#version 460 core
+#ifdef MULTI_VIEW
+#extension GL_ARB_shader_viewport_layer_array : enable
+#endif
+
+#include "multiview.glsl"
+#include "uniforms.glsl"
+
+// Vertex pulling: no vertex attributes, everything is fetched from storage
+// buffers. gl_VertexID walks the index range of the mesh and gl_DrawID selects
+// the draw record of the current multi-draw command.
+
+struct DrawRecord {
+    uint baseVertex;
+    uint firstModel;
+};
+
+layout (std430, binding = 0) readonly buffer Models { mat4 models[]; };
+layout (std430, binding = 8) readonly buffer Vertices { uint vertices[]; };
+layout (std430, binding = 9) readonly buffer Indices { uint indices[]; };
+layout (std430, binding = 10) readonly buffer DrawRecords { DrawRecord drawRecords[]; };
+
+out vec3 color;
+out vec2 texCoords;
+out vec3 viewPosition;
+
+invariant gl_Position;
+
+// position (3 x float), color (RGBA8), texture coordinates (2 x half)
+const uint vertexSize = 5;
+
+void main()
+{
+    const DrawRecord record = drawRecords[gl_DrawID];
+    const uint base = (record.baseVertex + indices[gl_VertexID]) * vertexSize;
+
+    const vec3 inPosition = uintBitsToFloat(uvec3(vertices[base], vertices[base + 1], vertices[base + 2]));
+    color = unpackUnorm4x8(vertices[base + 3]).rgb;
+    texCoords = unpackHalf2x16(vertices[base + 4]);
+
+    const mat4 model = models[record.firstModel + getInstance()];
+    const vec4 position = model * vec4(inPosition, 1.0);
+    viewPosition = position.xyz;
+
+#ifdef MULTI_VIEW
+    gl_Position = projectToView(position);
+#else
+    gl_Position = projection * position;
+#endif
+}
@@ -0,0 +1,11 @@
+// Uniform blocks of the scene shaders, see UniformRing. The projection is set
+// once per frame, the model once per draw.
+
+layout (std140, binding = 1) uniform Frame {
+    mat4 projection;
+    float time;
+};
+
+layout (std140, binding = 2) uniform Draw {
+    mat4 model;
+} draw;
@@ -0,0 +1,27 @@
+#version 460 core
+
+layout (binding = 0) uniform sampler2D source;
+
+uniform float sharpness;
+
+in vec2 texCoords;
+
+out vec4 fragColor;
+
+void main()
+{
+    // Bilinear upscale, then an unsharp mask over the source texel neighbors.
+    // Sharpening is clamped to the neighborhood to avoid ringing.
+    const vec2 texel = 1.0 / vec2(textureSize(source, 0));
+    const vec3 center = texture(source, texCoords).rgb;
+    const vec3 left = texture(source, texCoords - vec2(texel.x, 0.0)).rgb;
+    const vec3 right = texture(source, texCoords + vec2(texel.x, 0.0)).rgb;
+    const vec3 down = texture(source, texCoords - vec2(0.0, texel.y)).rgb;
+    const vec3 up = texture(source, texCoords + vec2(0.0, texel.y)).rgb;
+
+    const vec3 low = min(center, min(min(left, right), min(down, up)));
+    const vec3 high = max(center, max(max(left, right), max(down, up)));
+    const vec3 color = center + sharpness * (4.0 * center - left - right - down - up);
+
+    fragColor = vec4(clamp(color, low, high), 1.0);
+}
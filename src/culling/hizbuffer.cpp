@@ -0,0 +1,70 @@
+#include "culling/hizbuffer.hpp"
+#include <algorithm>
+#include <bit>
+#include <glad/gl.h>
+#include "math/vector.hpp"
+#include "shader.hpp"
+#include "utils/assertion.hpp"
+
+static constexpr int GroupSize = 8;
+
+HiZBuffer::HiZBuffer()
+    : shader{ Shader::loadFromFile("shaders/hiz.cs.glsl") }
+    , texture{ 0 }
+    , levelCount{ 0 }
+{
+}
+
+HiZBuffer::~HiZBuffer()
+{
+    glDeleteTextures(1, &texture);
+}
+
+void HiZBuffer::build(GLuint depthTexture, const Vector2i& depthSize)
+{
+    Assert(shader && depthTexture != 0);
+
+    resize(depthSize);
+
+    shader.bind();
+    glBindTextureUnit(0, depthTexture);
+
+    Vector2i sourceSize = size;
+    for (int level = 0; level < levelCount; ++level) {
+        const Vector2i levelSize{ std::max(size.x >> level, 1), std::max(size.y >> level, 1) };
+
+        shader.setUniform("level", level);
+        shader.setUniform("sourceSize", Vector2f{ sourceSize });
+
+        if (level > 0)
+            glBindImageTexture(0, texture, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+        glBindImageTexture(1, texture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+        glDispatchCompute((levelSize.x + GroupSize - 1) / GroupSize, (levelSize.y + GroupSize - 1) / GroupSize, 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+        sourceSize = levelSize;
+    }
+
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void HiZBuffer::resize(const Vector2i& size)
+{
+    Assert(size.x > 0 && size.y > 0);
+
+    if (texture != 0 && size == this->size)
+        return;
+
+    glDeleteTextures(1, &texture);
+
+    this->size = size;
+    levelCount = std::bit_width(static_cast<unsigned int>(std::max(size.x, size.y)));
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+    glTextureStorage2D(texture, levelCount, GL_R32F, size.x, size.y);
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
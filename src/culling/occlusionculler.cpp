@@ -0,0 +1,182 @@
+#include "culling/occlusionculler.hpp"
+#include <span>
+#include <glad/gl.h>
+#include "framebuffer.hpp"
+#include "math/boundingbox.hpp"
+#include "math/matrix.hpp"
+#include "mesh.hpp"
+#include "shader.hpp"
+#include "utils/assertion.hpp"
+
+static constexpr int GroupSize = 64;
+
+OcclusionCuller::OcclusionCuller(int capacity)
+    : cullShader{ Shader::loadFromFile("shaders/cull.cs.glsl") }
+    , capacity{ capacity }
+    , instanceCount{ 0 }
+    , occlusionCulling{ true }
+    , viewCount{ 1 }
+    , readbackIndex{ 0 }
+{
+    Assert(capacity > 0);
+
+    glCreateBuffers(1, &modelBuffer);
+    glNamedBufferStorage(modelBuffer, capacity * sizeof(Matrix4f), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    // Everything starts out visible so that the first late phase has a full
+    // depth buffer to test against.
+    const GLuint visible = 1;
+    glCreateBuffers(1, &visibilityBuffer);
+    glNamedBufferStorage(visibilityBuffer, capacity * sizeof(GLuint), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glClearNamedBufferData(visibilityBuffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &visible);
+
+    glCreateBuffers(1, &instanceBuffer);
+    glNamedBufferStorage(instanceBuffer, 2 * capacity * sizeof(GLuint), nullptr, 0);
+
+    glCreateBuffers(1, &counterBuffer);
+    glNamedBufferStorage(counterBuffer, sizeof(Counters), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    for (Readback& readback : readbacks) {
+        glCreateBuffers(1, &readback.buffer);
+        glNamedBufferStorage(readback.buffer, sizeof(Counters), nullptr, flags);
+        readback.counters = static_cast<const Counters*>(glMapNamedBufferRange(readback.buffer, 0, sizeof(Counters), flags));
+    }
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+    for (Readback& readback : readbacks) {
+        glDeleteSync(readback.fence);
+        glDeleteBuffers(1, &readback.buffer);
+    }
+
+    glDeleteBuffers(1, &counterBuffer);
+    glDeleteBuffers(1, &instanceBuffer);
+    glDeleteBuffers(1, &visibilityBuffer);
+    glDeleteBuffers(1, &modelBuffer);
+}
+
+void OcclusionCuller::setInstances(std::span<const Matrix4f> models, const BoundingBox& bounds)
+{
+    Assert(static_cast<int>(models.size()) <= capacity);
+
+    glNamedBufferSubData(modelBuffer, 0, models.size_bytes(), models.data());
+
+    instanceCount = models.size();
+    this->bounds = bounds;
+}
+
+void OcclusionCuller::setViewCount(int viewCount)
+{
+    Assert(viewCount > 0);
+
+    this->viewCount = viewCount;
+}
+
+void OcclusionCuller::render(const Matrix4f& viewProjection, const Framebuffer& framebuffer, Shader& shader, const Mesh& mesh, Mesh::Stream stream)
+{
+    Assert(*this);
+
+    readStatistics();
+
+    if (instanceCount == 0)
+        return;
+
+    const GLuint count = mesh.getCount();
+    const Counters counters{
+        .commands = {
+            { .count = count, .instanceCount = 0, .firstIndex = 0, .baseVertex = 0, .baseInstance = 0 },
+            { .count = count, .instanceCount = 0, .firstIndex = 0, .baseVertex = 0, .baseInstance = static_cast<GLuint>(capacity) } },
+        .frustumCulledCount = 0,
+        .occlusionCulledCount = 0
+    };
+    glNamedBufferSubData(counterBuffer, 0, sizeof(Counters), &counters);
+
+    bindBuffers();
+
+    cull(0, viewProjection);
+    shader.bind();
+    mesh.drawIndirect(0, stream);
+
+    if (occlusionCulling)
+        hiz.build(framebuffer.getDepthTexture(), framebuffer.getSize());
+
+    cull(1, viewProjection);
+    shader.bind();
+    mesh.drawIndirect(sizeof(DrawCommand), stream);
+
+    Readback& readback = readbacks[readbackIndex];
+    glCopyNamedBufferSubData(counterBuffer, readback.buffer, 0, 0, sizeof(Counters));
+    glDeleteSync(readback.fence);
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.instanceCount = instanceCount;
+    readback.viewCount = viewCount;
+
+    readbackIndex = (readbackIndex + 1) % ReadbackCount;
+}
+
+void OcclusionCuller::redraw(Shader& shader, const Mesh& mesh, Mesh::Stream stream) const
+{
+    if (instanceCount == 0)
+        return;
+
+    bindBuffers();
+
+    shader.bind();
+    mesh.drawIndirect(0, stream);
+    mesh.drawIndirect(sizeof(DrawCommand), stream);
+}
+
+void OcclusionCuller::bindBuffers() const
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, modelBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visibilityBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, instanceBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, counterBuffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, counterBuffer);
+}
+
+void OcclusionCuller::cull(int phase, const Matrix4f& viewProjection)
+{
+    cullShader.setUniform("instanceCount", instanceCount);
+    cullShader.setUniform("phase", phase);
+    cullShader.setUniform("occlusionCulling", occlusionCulling ? 1 : 0);
+    cullShader.setUniform("viewCount", viewCount);
+    cullShader.setUniform("viewProjection", viewProjection);
+    cullShader.setUniform("boundsMin", bounds.min);
+    cullShader.setUniform("boundsMax", bounds.max);
+
+    if (phase == 1) {
+        cullShader.setUniform("hizSize", Vector2f{ hiz.getSize() });
+        cullShader.setUniform("hizLevelCount", hiz.getLevelCount());
+        glBindTextureUnit(0, hiz.getTexture());
+    }
+
+    cullShader.bind();
+    glDispatchCompute((instanceCount + GroupSize - 1) / GroupSize, 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void OcclusionCuller::readStatistics()
+{
+    // The slot about to be overwritten is the oldest one in flight.
+    Readback& readback = readbacks[readbackIndex];
+    if (!readback.fence)
+        return;
+
+    if (glClientWaitSync(readback.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        return;
+
+    const Counters& counters = *readback.counters;
+    statistics = Statistics{
+        .instanceCount = readback.instanceCount,
+        .earlyDrawCount = static_cast<int>(counters.commands[0].instanceCount) / readback.viewCount,
+        .lateDrawCount = static_cast<int>(counters.commands[1].instanceCount) / readback.viewCount,
+        .frustumCulledCount = static_cast<int>(counters.frustumCulledCount),
+        .occlusionCulledCount = static_cast<int>(counters.occlusionCulledCount)
+    };
+
+    glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+}
@@ -0,0 +1,169 @@
+#include "culling/occlusionqueries.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <glad/gl.h>
+#include "math/boundingbox.hpp"
+#include "math/matrix.hpp"
+#include "math/vector.hpp"
+#include "mesh.hpp"
+#include "multiview.hpp"
+#include "shader.hpp"
+#include "uniformring.hpp"
+#include "utils/assertion.hpp"
+
+static constexpr std::string_view MultiViewDefines[] = { MultiView::Keyword };
+
+// The bounding box test would be clipped away by the near plane, so such
+// objects are treated as visible.
+static bool intersectsNearPlane(const Matrix4f& modelViewProjection, const BoundingBox& bounds)
+{
+    for (int i = 0; i < 8; ++i) {
+        const Vector4f corner{
+            i & 1 ? bounds.max.x : bounds.min.x,
+            i & 2 ? bounds.max.y : bounds.min.y,
+            i & 4 ? bounds.max.z : bounds.min.z,
+            1
+        };
+        const Vector4f clip = modelViewProjection * corner;
+
+        if (clip.z < -clip.w)
+            return true;
+    }
+
+    return false;
+}
+
+OcclusionQueries::OcclusionQueries(int capacity, int requeryInterval)
+    : boundsShader{ Shader::loadFromFile("shaders/bounds.vs.glsl", "shaders/depth.fs.glsl") }
+    , multiViewBoundsShader{ Shader::loadFromFile("shaders/bounds.vs.glsl", "shaders/depth.fs.glsl", MultiViewDefines) }
+    , capacity{ capacity }
+    , requeryInterval{ requeryInterval }
+    , enabled{ true }
+    , states(capacity)
+    , frame{ 0 }
+{
+    Assert(capacity > 0);
+
+    // Boxes are generated from gl_VertexID.
+    glCreateVertexArrays(1, &vertexArray);
+
+    for (State& state : states) {
+        glCreateQueries(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, 1, &state.query);
+        state.lastQueryFrame = 0;
+        state.pending = false;
+        state.visible = true;
+    }
+}
+
+OcclusionQueries::~OcclusionQueries()
+{
+    for (State& state : states)
+        glDeleteQueries(1, &state.query);
+
+    glDeleteVertexArrays(1, &vertexArray);
+}
+
+void OcclusionQueries::render(std::span<const Matrix4f> viewProjections, std::span<const Object> objects, Shader& shader, UniformRing& uniforms)
+{
+    Assert(*this && static_cast<int>(objects.size()) <= capacity);
+    Assert(!viewProjections.empty());
+
+    const int viewCount = static_cast<int>(viewProjections.size());
+
+    ++frame;
+
+    statistics = Statistics{ .objectCount = static_cast<int>(objects.size()) };
+
+    for (std::size_t i = 0; i < objects.size(); ++i) {
+        const Object& object = objects[i];
+        State& state = states[i];
+
+        readResult(state);
+
+        if (!state.visible) {
+            ++statistics.skippedDrawCount;
+            statistics.skippedTriangleCount += object.mesh->getCount() / 3;
+        }
+
+        const auto crossesNearPlane = [&](const Matrix4f& viewProjection) {
+            return intersectsNearPlane(viewProjection * object.model, object.mesh->getBounds());
+        };
+
+        bool conditional = false;
+        if (enabled && std::none_of(viewProjections.begin(), viewProjections.end(), crossesNearPlane)) {
+            // A query still in flight keeps guarding the draw until it is read.
+            if (!state.pending && (!state.visible || frame - state.lastQueryFrame >= requeryInterval)) {
+                drawBounds(viewProjections, object, state.query);
+
+                state.pending = true;
+                state.lastQueryFrame = frame;
+                ++statistics.queryCount;
+            }
+
+            conditional = state.pending;
+        } else {
+            state.visible = true;
+        }
+
+        uniforms.bindDraw(object.model);
+        shader.bind();
+
+        if (conditional) {
+            glBeginConditionalRender(state.query, GL_QUERY_WAIT);
+            object.mesh->drawInstanced(viewCount, 0);
+            glEndConditionalRender();
+
+            ++statistics.conditionalDrawCount;
+        } else {
+            object.mesh->drawInstanced(viewCount, 0);
+        }
+    }
+}
+
+void OcclusionQueries::readResult(State& state) const
+{
+    if (!state.pending)
+        return;
+
+    GLuint available;
+    glGetQueryObjectuiv(state.query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return;
+
+    GLuint passed;
+    glGetQueryObjectuiv(state.query, GL_QUERY_RESULT, &passed);
+
+    state.pending = false;
+    state.visible = passed != 0;
+}
+
+void OcclusionQueries::drawBounds(std::span<const Matrix4f> viewProjections, const Object& object, GLuint query)
+{
+    const BoundingBox& bounds = object.mesh->getBounds();
+    const int viewCount = static_cast<int>(viewProjections.size());
+
+    // The multi-view variant reads the view projections from MultiView.
+    Shader& shader = viewCount > 1 ? multiViewBoundsShader : boundsShader;
+    shader.setUniform("model", object.model);
+    if (viewCount == 1)
+        shader.setUniform("viewProjection", viewProjections.front());
+    shader.setUniform("boundsMin", bounds.min);
+    shader.setUniform("boundsMax", bounds.max);
+    shader.bind();
+
+    // The box strip does not keep a consistent winding.
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    glDisable(GL_CULL_FACE);
+
+    glBindVertexArray(vertexArray);
+    glBeginQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, query);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 14, viewCount);
+    glEndQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE);
+
+    glEnable(GL_CULL_FACE);
+    glDepthMask(GL_TRUE);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
@@ -0,0 +1,258 @@
+#include "culling/occlusionrasterizer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include "math/boundingbox.hpp"
+#include "math/matrix.hpp"
+#include "math/vector.hpp"
+#include "mesh.hpp"
+#include "utils/assertion.hpp"
+#include "utils/simd.hpp"
+#include "utils/threadpool.hpp"
+
+OcclusionRasterizer::OcclusionRasterizer(ThreadPool& threadPool, const Vector2i& size)
+    : threadPool{ threadPool }
+    , size{ size }
+    , tileCount{ size.x / TileWidth, size.y / TileHeight }
+    , depth(size.x * size.y, 1.f)
+    , tileMaxDepth(tileCount.x * tileCount.y, 1.f)
+    , bins(tileCount.x * tileCount.y)
+{
+    Assert(size.x > 0 && size.y > 0 && size.x % TileWidth == 0 && size.y % TileHeight == 0);
+}
+
+void OcclusionRasterizer::begin(const Matrix4f& viewProjection)
+{
+    this->viewProjection = viewProjection;
+
+    triangles.clear();
+    for (std::vector<int>& bin : bins)
+        bin.clear();
+}
+
+void OcclusionRasterizer::addOccluder(std::span<const Mesh::Vertex> vertices, std::span<const unsigned int> indices, const Matrix4f& model)
+{
+    Assert(indices.size() % 3 == 0);
+
+    const Matrix4f mvp = viewProjection * model;
+
+    for (std::size_t i = 0; i < indices.size(); i += 3) {
+        Vector4f clip[3];
+        for (int j = 0; j < 3; ++j)
+            clip[j] = mvp * Vector4f{ vertices[indices[i + j]].position, 1 };
+
+        // Clip against the near plane (z >= -w); the other planes are handled
+        // by clamping to the screen.
+        Vector4f polygon[4];
+        int vertexCount = 0;
+        for (int j = 0; j < 3; ++j) {
+            const Vector4f& a = clip[j];
+            const Vector4f& b = clip[(j + 1) % 3];
+            const float da = a.z + a.w;
+            const float db = b.z + b.w;
+
+            if (da >= 0)
+                polygon[vertexCount++] = a;
+            if ((da >= 0) != (db >= 0))
+                polygon[vertexCount++] = a + (da / (da - db)) * (b - a);
+        }
+
+        for (int j = 2; j < vertexCount; ++j)
+            addTriangle(polygon[0], polygon[j - 1], polygon[j]);
+    }
+}
+
+void OcclusionRasterizer::rasterize()
+{
+    threadPool.parallelFor(tileCount.x * tileCount.y, [this](int tile) {
+        rasterizeTile(tile);
+    });
+}
+
+bool OcclusionRasterizer::isVisible(const BoundingBox& bounds, const Matrix4f& model) const
+{
+    const Matrix4f mvp = viewProjection * model;
+
+    Vector3f screenMin{ std::numeric_limits<float>::max() };
+    Vector3f screenMax{ std::numeric_limits<float>::lowest() };
+
+    for (int i = 0; i < 8; ++i) {
+        const Vector3f corner{
+            i & 1 ? bounds.max.x : bounds.min.x,
+            i & 2 ? bounds.max.y : bounds.min.y,
+            i & 4 ? bounds.max.z : bounds.min.z
+        };
+        const Vector4f clip = mvp * Vector4f{ corner, 1 };
+
+        // Boxes crossing the near plane cannot be tested conservatively.
+        if (clip.z < -clip.w || clip.w <= 0)
+            return true;
+
+        const Vector3f p{
+            (0.5f * clip.x / clip.w + 0.5f) * size.x,
+            (0.5f * clip.y / clip.w + 0.5f) * size.y,
+            0.5f * clip.z / clip.w + 0.5f
+        };
+        screenMin = Vector3f{ std::min(screenMin.x, p.x), std::min(screenMin.y, p.y), std::min(screenMin.z, p.z) };
+        screenMax = Vector3f{ std::max(screenMax.x, p.x), std::max(screenMax.y, p.y), std::max(screenMax.z, p.z) };
+    }
+
+    const int x0 = std::max(static_cast<int>(std::floor(screenMin.x)), 0);
+    const int y0 = std::max(static_cast<int>(std::floor(screenMin.y)), 0);
+    const int x1 = std::min(static_cast<int>(std::ceil(screenMax.x)), size.x);
+    const int y1 = std::min(static_cast<int>(std::ceil(screenMax.y)), size.y);
+    if (x0 >= x1 || y0 >= y1 || screenMin.z > 1)
+        return false;
+
+    // Coarse test against the farthest depth of each covered tile.
+    bool coarseOccluded = true;
+    for (int ty = y0 / TileHeight; ty <= (y1 - 1) / TileHeight && coarseOccluded; ++ty)
+        for (int tx = x0 / TileWidth; tx <= (x1 - 1) / TileWidth && coarseOccluded; ++tx)
+            coarseOccluded = screenMin.z > tileMaxDepth[ty * tileCount.x + tx];
+
+    if (coarseOccluded)
+        return false;
+
+    const Float4 z{ screenMin.z };
+    const Float4 laneX{ 0, 1, 2, 3 };
+
+    for (int y = y0; y < y1; ++y) {
+        const float* row = depth.data() + y * size.x;
+
+        for (int x = x0 & ~3; x < x1; x += 4) {
+            const Float4 px = Float4{ static_cast<float>(x) } + laneX;
+            const Float4 inside = (px >= Float4{ static_cast<float>(x0) }) & (px < Float4{ static_cast<float>(x1) });
+
+            if (moveMask(inside & (z <= Float4::load(row + x))) != 0)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+int OcclusionRasterizer::testVisibility(const BoundingBox& bounds, std::span<const Matrix4f> models, std::span<std::uint8_t> visible) const
+{
+    Assert(visible.size() >= models.size());
+
+    static constexpr int BatchSize = 256;
+    const int batchCount = (static_cast<int>(models.size()) + BatchSize - 1) / BatchSize;
+
+    threadPool.parallelFor(batchCount, [&](int batch) {
+        const std::size_t end = std::min(models.size(), static_cast<std::size_t>(batch + 1) * BatchSize);
+        for (std::size_t i = batch * BatchSize; i < end; ++i)
+            visible[i] = isVisible(bounds, models[i]);
+    });
+
+    return std::count(visible.begin(), visible.begin() + models.size(), std::uint8_t{ 1 });
+}
+
+void OcclusionRasterizer::addTriangle(const Vector4f& c0, const Vector4f& c1, const Vector4f& c2)
+{
+    Triangle triangle;
+
+    const Vector4f* clip[3] = { &c0, &c1, &c2 };
+    for (int i = 0; i < 3; ++i) {
+        const Vector4f& c = *clip[i];
+        triangle.vertices[i] = Vector3f{
+            (0.5f * c.x / c.w + 0.5f) * size.x,
+            (0.5f * c.y / c.w + 0.5f) * size.y,
+            0.5f * c.z / c.w + 0.5f
+        };
+    }
+
+    const Vector3f& v0 = triangle.vertices[0];
+    const Vector3f& v1 = triangle.vertices[1];
+    const Vector3f& v2 = triangle.vertices[2];
+
+    // Counter-clockwise triangles are front facing; back faces and degenerate
+    // triangles never occlude anything a closed occluder does not already cover.
+    const float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+    if (area <= 0)
+        return;
+
+    const int x0 = std::max(static_cast<int>(std::min({ v0.x, v1.x, v2.x })), 0);
+    const int y0 = std::max(static_cast<int>(std::min({ v0.y, v1.y, v2.y })), 0);
+    const int x1 = std::min(static_cast<int>(std::max({ v0.x, v1.x, v2.x })), size.x - 1);
+    const int y1 = std::min(static_cast<int>(std::max({ v0.y, v1.y, v2.y })), size.y - 1);
+    if (x0 > x1 || y0 > y1)
+        return;
+
+    const int index = triangles.size();
+    triangles.push_back(triangle);
+
+    for (int ty = y0 / TileHeight; ty <= y1 / TileHeight; ++ty)
+        for (int tx = x0 / TileWidth; tx <= x1 / TileWidth; ++tx)
+            bins[ty * tileCount.x + tx].push_back(index);
+}
+
+void OcclusionRasterizer::rasterizeTile(int tile)
+{
+    const int tileX = (tile % tileCount.x) * TileWidth;
+    const int tileY = (tile / tileCount.x) * TileHeight;
+
+    for (int y = tileY; y < tileY + TileHeight; ++y) {
+        float* row = depth.data() + y * size.x + tileX;
+        std::fill(row, row + TileWidth, 1.f);
+    }
+
+    const Float4 laneX{ 0.5f, 1.5f, 2.5f, 3.5f };
+
+    for (int index : bins[tile]) {
+        const Triangle& triangle = triangles[index];
+        const Vector3f& v0 = triangle.vertices[0];
+        const Vector3f& v1 = triangle.vertices[1];
+        const Vector3f& v2 = triangle.vertices[2];
+
+        // Edge functions E(x, y) = a * x + b * y + c, positive inside.
+        const float a0 = v1.y - v2.y, b0 = v2.x - v1.x, c0 = v1.x * v2.y - v1.y * v2.x;
+        const float a1 = v2.y - v0.y, b1 = v0.x - v2.x, c1 = v2.x * v0.y - v2.y * v0.x;
+        const float a2 = v0.y - v1.y, b2 = v1.x - v0.x, c2 = v0.x * v1.y - v0.y * v1.x;
+
+        // Depth is affine in screen space, interpolated from the normalized
+        // edge functions (barycentric coordinates).
+        const float inverseArea = 1 / (c0 + c1 + c2);
+        const float za = (a0 * v0.z + a1 * v1.z + a2 * v2.z) * inverseArea;
+        const float zb = (b0 * v0.z + b1 * v1.z + b2 * v2.z) * inverseArea;
+        const float zc = (c0 * v0.z + c1 * v1.z + c2 * v2.z) * inverseArea;
+
+        const int x0 = std::max(static_cast<int>(std::min({ v0.x, v1.x, v2.x })), tileX) & ~3;
+        const int y0 = std::max(static_cast<int>(std::min({ v0.y, v1.y, v2.y })), tileY);
+        const int x1 = std::min(static_cast<int>(std::max({ v0.x, v1.x, v2.x })) + 1, tileX + TileWidth);
+        const int y1 = std::min(static_cast<int>(std::max({ v0.y, v1.y, v2.y })) + 1, tileY + TileHeight);
+
+        for (int y = y0; y < y1; ++y) {
+            const float py = y + 0.5f;
+            const Float4 e0y{ b0 * py + c0 };
+            const Float4 e1y{ b1 * py + c1 };
+            const Float4 e2y{ b2 * py + c2 };
+            const Float4 zy{ zb * py + zc };
+
+            float* row = depth.data() + y * size.x;
+
+            for (int x = x0; x < x1; x += 4) {
+                const Float4 px = Float4{ static_cast<float>(x) } + laneX;
+                const Float4 e0 = Float4{ a0 } * px + e0y;
+                const Float4 e1 = Float4{ a1 } * px + e1y;
+                const Float4 e2 = Float4{ a2 } * px + e2y;
+                const Float4 inside = (e0 >= Float4{ 0.f }) & (e1 >= Float4{ 0.f }) & (e2 >= Float4{ 0.f });
+                if (moveMask(inside) == 0)
+                    continue;
+
+                const Float4 z = Float4{ za } * px + zy;
+                const Float4 d = Float4::load(row + x);
+                select(inside & (z < d), z, d).store(row + x);
+            }
+        }
+    }
+
+    float maxDepth = 0;
+    for (int y = tileY; y < tileY + TileHeight; ++y) {
+        const float* row = depth.data() + y * size.x + tileX;
+        maxDepth = std::max(maxDepth, *std::max_element(row, row + TileWidth));
+    }
+
+    tileMaxDepth[tile] = maxDepth;
+}
@@ -0,0 +1,286 @@
+#include "debugdraw.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numbers>
+#include <span>
+#include <string_view>
+#include <glad/gl.h>
+#include "math/boundingbox.hpp"
+#include "math/matrix.hpp"
+#include "math/vector.hpp"
+#include "multiview.hpp"
+#include "shader.hpp"
+#include "utils/assertion.hpp"
+
+static constexpr int CircleSegmentCount = 24;
+static constexpr std::string_view MultiViewDefines[] = { MultiView::Keyword };
+
+static std::uint32_t packColor(const Vector3f& color)
+{
+    const auto pack = [](float f) {
+        return static_cast<std::uint32_t>(std::clamp(f, 0.f, 1.f) * 255 + 0.5f);
+    };
+
+    return pack(color.x) | pack(color.y) << 8 | pack(color.z) << 16 | 0xff000000;
+}
+
+static std::array<Vector3f, 8> getCorners(const BoundingBox& box)
+{
+    std::array<Vector3f, 8> corners;
+    for (int i = 0; i < 8; ++i)
+        corners[i] = Vector3f{
+            i & 1 ? box.max.x : box.min.x,
+            i & 2 ? box.max.y : box.min.y,
+            i & 4 ? box.max.z : box.min.z
+        };
+
+    return corners;
+}
+
+// Any vector orthogonal to v.
+static Vector3f getOrthogonal(const Vector3f& v)
+{
+    return std::abs(v.x) < 0.9f ? cross(v, Vector3f{ 1, 0, 0 }) : cross(v, Vector3f{ 0, 1, 0 });
+}
+
+DebugDraw::DebugDraw(int capacity)
+    : shader{ Shader::loadFromFile("shaders/debug.vs.glsl", "shaders/debug.fs.glsl") }
+    , multiViewShader{ Shader::loadFromFile("shaders/debug.vs.glsl", "shaders/debug.fs.glsl", MultiViewDefines) }
+    , capacity{ capacity }
+    , counts{}
+    , droppedVertexCount{ 0 }
+{
+    Assert(capacity > 0);
+
+    const GLsizeiptr size = FrameRing::FrameCount * PrimitiveCount * capacity * sizeof(Vertex);
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glCreateBuffers(1, &vertexBuffer);
+    glNamedBufferStorage(vertexBuffer, size, nullptr, flags);
+    vertices = static_cast<Vertex*>(glMapNamedBufferRange(vertexBuffer, 0, size, flags));
+
+    glCreateVertexArrays(1, &vertexArray);
+    glVertexArrayVertexBuffer(vertexArray, 0, vertexBuffer, 0, sizeof(Vertex));
+
+    glEnableVertexArrayAttrib(vertexArray, 0);
+    glVertexArrayAttribFormat(vertexArray, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, position));
+    glVertexArrayAttribBinding(vertexArray, 0, 0);
+
+    glEnableVertexArrayAttrib(vertexArray, 1);
+    glVertexArrayAttribFormat(vertexArray, 1, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(Vertex, color));
+    glVertexArrayAttribBinding(vertexArray, 1, 0);
+}
+
+DebugDraw::~DebugDraw()
+{
+    glUnmapNamedBuffer(vertexBuffer);
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteVertexArrays(1, &vertexArray);
+}
+
+void DebugDraw::begin()
+{
+    ring.advance();
+
+    for (std::atomic<int>& count : counts)
+        count = 0;
+    droppedVertexCount = 0;
+}
+
+void DebugDraw::flush(const Matrix4f& viewProjection, int viewCount)
+{
+    Assert(*this && viewCount > 0);
+
+    if (viewCount > 1) {
+        multiViewShader.bind();
+    } else {
+        shader.setUniform("viewProjection", viewProjection);
+        shader.bind();
+    }
+    glBindVertexArray(vertexArray);
+
+    const GLenum modes[PrimitiveCount] = { GL_LINES, GL_TRIANGLES };
+    for (int primitive = 0; primitive < PrimitiveCount; ++primitive) {
+        const int count = counts[primitive].load();
+        if (count > 0)
+            glDrawArraysInstanced(modes[primitive], (ring.getFrame() * PrimitiveCount + primitive) * capacity, count, viewCount);
+    }
+
+    ring.fence();
+}
+
+void DebugDraw::line(const Vector3f& a, const Vector3f& b, const Vector3f& color)
+{
+    Vertex* v = reserve(Lines, 2);
+    if (!v)
+        return;
+
+    const std::uint32_t c = packColor(color);
+    v[0] = Vertex{ a, c };
+    v[1] = Vertex{ b, c };
+}
+
+void DebugDraw::polyline(std::span<const Vector3f> points, const Vector3f& color)
+{
+    if (points.size() < 2)
+        return;
+
+    Vertex* v = reserve(Lines, 2 * (points.size() - 1));
+    if (!v)
+        return;
+
+    const std::uint32_t c = packColor(color);
+    for (std::size_t i = 1; i < points.size(); ++i) {
+        *v++ = Vertex{ points[i - 1], c };
+        *v++ = Vertex{ points[i], c };
+    }
+}
+
+void DebugDraw::box(const BoundingBox& box, const Vector3f& color)
+{
+    boxLines(getCorners(box), color);
+}
+
+void DebugDraw::box(const BoundingBox& box, const Matrix4f& model, const Vector3f& color)
+{
+    std::array<Vector3f, 8> corners = getCorners(box);
+    for (Vector3f& corner : corners) {
+        const Vector4f p = model * Vector4f{ corner, 1 };
+        corner = Vector3f{ p.x, p.y, p.z };
+    }
+
+    boxLines(corners, color);
+}
+
+void DebugDraw::solidBox(const BoundingBox& box, const Vector3f& color)
+{
+    // Corner index bits are x, y, z; faces wound counter-clockwise from outside.
+    static constexpr int faces[6][4] = {
+        { 1, 3, 7, 5 }, { 0, 4, 6, 2 },
+        { 2, 6, 7, 3 }, { 0, 1, 5, 4 },
+        { 4, 5, 7, 6 }, { 0, 2, 3, 1 }
+    };
+
+    Vertex* v = reserve(Triangles, 36);
+    if (!v)
+        return;
+
+    const std::array<Vector3f, 8> corners = getCorners(box);
+    const std::uint32_t c = packColor(color);
+
+    for (const auto& face : faces)
+        for (int i : { 0, 1, 2, 2, 3, 0 })
+            *v++ = Vertex{ corners[face[i]], c };
+}
+
+void DebugDraw::sphere(const Vector3f& center, float radius, const Vector3f& color)
+{
+    Vertex* v = reserve(Lines, 3 * 2 * CircleSegmentCount);
+    if (!v)
+        return;
+
+    const std::uint32_t c = packColor(color);
+
+    // One circle in each axis plane.
+    for (int axis = 0; axis < 3; ++axis)
+        for (int i = 0; i < CircleSegmentCount; ++i)
+            for (int j : { i, i + 1 }) {
+                const float angle = 2 * std::numbers::pi_v<float> * j / CircleSegmentCount;
+                const float a = radius * std::cos(angle);
+                const float b = radius * std::sin(angle);
+                const Vector3f offset = axis == 0 ? Vector3f{ 0, a, b } : axis == 1 ? Vector3f{ a, 0, b } : Vector3f{ a, b, 0 };
+
+                *v++ = Vertex{ center + offset, c };
+            }
+}
+
+void DebugDraw::arrow(const Vector3f& from, const Vector3f& to, const Vector3f& color)
+{
+    const Vector3f direction = to - from;
+    const float arrowLength = length(direction);
+    if (arrowLength == 0)
+        return;
+
+    // Shaft as a line, head as a cone of triangles.
+    static constexpr int HeadSegmentCount = 8;
+
+    Vertex* shaft = reserve(Lines, 2);
+    Vertex* head = reserve(Triangles, 3 * HeadSegmentCount);
+    const std::uint32_t c = packColor(color);
+
+    const Vector3f axis = direction / arrowLength;
+    const float headLength = 0.2f * arrowLength;
+    const Vector3f base = to - headLength * axis;
+
+    if (shaft) {
+        shaft[0] = Vertex{ from, c };
+        shaft[1] = Vertex{ base, c };
+    }
+
+    if (!head)
+        return;
+
+    const Vector3f u = normalize(getOrthogonal(axis));
+    const Vector3f w = cross(axis, u);
+    const float radius = 0.4f * headLength;
+
+    for (int i = 0; i < HeadSegmentCount; ++i) {
+        const float a0 = 2 * std::numbers::pi_v<float> * i / HeadSegmentCount;
+        const float a1 = 2 * std::numbers::pi_v<float> * (i + 1) / HeadSegmentCount;
+
+        *head++ = Vertex{ base + radius * (std::cos(a0) * u + std::sin(a0) * w), c };
+        *head++ = Vertex{ base + radius * (std::cos(a1) * u + std::sin(a1) * w), c };
+        *head++ = Vertex{ to, c };
+    }
+}
+
+void DebugDraw::frustum(float fovY, float aspect, float zNear, float zFar, const Vector3f& color)
+{
+    const float tanHalfFovY = std::tan(0.5f * fovY);
+
+    std::array<Vector3f, 8> corners;
+    for (int i = 0; i < 8; ++i) {
+        const float z = i & 4 ? zFar : zNear;
+        const float y = (i & 2 ? 1 : -1) * z * tanHalfFovY;
+        const float x = (i & 1 ? 1 : -1) * z * tanHalfFovY * aspect;
+
+        corners[i] = Vector3f{ x, y, -z };
+    }
+
+    boxLines(corners, color);
+}
+
+DebugDraw::Vertex* DebugDraw::reserve(Primitive primitive, int count)
+{
+    // The count only grows by reservations that fit, so that every vertex
+    // below it was written this frame.
+    int first = counts[primitive].load(std::memory_order_relaxed);
+    do {
+        if (first + count > capacity) {
+            droppedVertexCount += count;
+            return nullptr;
+        }
+    } while (!counts[primitive].compare_exchange_weak(first, first + count, std::memory_order_relaxed));
+
+    return vertices + (ring.getFrame() * PrimitiveCount + primitive) * capacity + first;
+}
+
+void DebugDraw::boxLines(const std::array<Vector3f, 8>& corners, const Vector3f& color)
+{
+    // The twelve edges join corners whose indices differ by a single bit.
+    Vertex* v = reserve(Lines, 24);
+    if (!v)
+        return;
+
+    const std::uint32_t c = packColor(color);
+
+    for (int i = 0; i < 8; ++i)
+        for (int bit : { 1, 2, 4 })
+            if (!(i & bit)) {
+                *v++ = Vertex{ corners[i], c };
+                *v++ = Vertex{ corners[i | bit], c };
+            }
+}
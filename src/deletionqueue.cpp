@@ -0,0 +1,125 @@
+#include "deletionqueue.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <glad/gl.h>
+
+static constexpr std::size_t TypeCount = 4;
+
+using Names = std::array<std::vector<GLuint>, TypeCount>;
+
+struct DeletionBatch {
+    GLsync fence;
+    Names names;
+};
+
+struct DeletionState {
+    std::mutex mutex;
+    Names pending;
+    std::deque<DeletionBatch> batches;
+    DeletionQueue::Statistics statistics;
+};
+
+static DeletionState state;
+
+static int countNames(const Names& names)
+{
+    int count = 0;
+    for (const std::vector<GLuint>& typeNames : names)
+        count += typeNames.size();
+
+    return count;
+}
+
+static void deleteNames(const Names& names)
+{
+    const std::vector<GLuint>& buffers = names[static_cast<std::size_t>(DeletionQueue::Type::Buffer)];
+    const std::vector<GLuint>& vertexArrays = names[static_cast<std::size_t>(DeletionQueue::Type::VertexArray)];
+    const std::vector<GLuint>& shaders = names[static_cast<std::size_t>(DeletionQueue::Type::Shader)];
+    const std::vector<GLuint>& programs = names[static_cast<std::size_t>(DeletionQueue::Type::Program)];
+
+    if (!buffers.empty())
+        glDeleteBuffers(buffers.size(), buffers.data());
+    if (!vertexArrays.empty())
+        glDeleteVertexArrays(vertexArrays.size(), vertexArrays.data());
+    for (GLuint shader : shaders)
+        glDeleteShader(shader);
+    for (GLuint program : programs)
+        glDeleteProgram(program);
+}
+
+void DeletionQueue::enqueue(Type type, GLuint name)
+{
+    if (name == 0)
+        return;
+
+    const std::lock_guard lock{ state.mutex };
+    state.pending[static_cast<std::size_t>(type)].push_back(name);
+}
+
+void DeletionQueue::retire()
+{
+    DeletionBatch batch{ .fence = nullptr, .names = {} };
+    {
+        const std::lock_guard lock{ state.mutex };
+        batch.names.swap(state.pending);
+    }
+
+    if (countNames(batch.names) != 0) {
+        batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        state.batches.push_back(std::move(batch));
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    int deletedCount = 0;
+
+    // Fences signal in order, the first pending one ends the scan.
+    while (!state.batches.empty()) {
+        DeletionBatch& oldest = state.batches.front();
+        const GLenum status = glClientWaitSync(oldest.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+
+        glDeleteSync(oldest.fence);
+        deleteNames(oldest.names);
+        deletedCount += countNames(oldest.names);
+        state.batches.pop_front();
+    }
+
+    const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    int pendingCount = 0;
+    for (const DeletionBatch& pending : state.batches)
+        pendingCount += countNames(pending.names);
+
+    const std::lock_guard lock{ state.mutex };
+    state.statistics = Statistics{ .pendingCount = pendingCount, .deletedCount = deletedCount, .milliseconds = elapsed.count() };
+}
+
+void DeletionQueue::flush()
+{
+    Names names;
+    {
+        const std::lock_guard lock{ state.mutex };
+        names.swap(state.pending);
+    }
+
+    for (DeletionBatch& batch : state.batches) {
+        glClientWaitSync(batch.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(batch.fence);
+        deleteNames(batch.names);
+    }
+    state.batches.clear();
+
+    deleteNames(names);
+}
+
+DeletionQueue::Statistics DeletionQueue::getStatistics()
+{
+    const std::lock_guard lock{ state.mutex };
+    return state.statistics;
+}
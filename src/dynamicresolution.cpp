@@ -0,0 +1,97 @@
+#include "dynamicresolution.hpp"
+#include <algorithm>
+#include <cmath>
+#include "utils/assertion.hpp"
+
+static constexpr float Step = 1.f / 32;
+
+// Target fraction of the budget, leaves room for noise.
+static constexpr float Headroom = 0.9f;
+
+// Frames until timings reflect a new scale, and frames under budget before
+// growing.
+static constexpr int LatencyFrameCount = 6;
+static constexpr int GrowFrameCount = 30;
+
+DynamicResolution::DynamicResolution()
+    : enabled{ false }
+    , budget{ 1000.f / 60 }
+    , minScale{ 0.5f }
+    , scale{ 1 }
+    , cooldown{ 0 }
+    , underBudgetFrameCount{ 0 }
+{
+}
+
+void DynamicResolution::setEnabled(bool enabled)
+{
+    if (enabled == this->enabled)
+        return;
+
+    this->enabled = enabled;
+    if (!enabled)
+        setScale(1);
+}
+
+void DynamicResolution::setBudget(float milliseconds)
+{
+    Assert(milliseconds > 0);
+
+    budget = milliseconds;
+}
+
+void DynamicResolution::setMinScale(float minScale)
+{
+    Assert(minScale > 0 && minScale <= 1);
+
+    this->minScale = minScale;
+    if (scale < minScale)
+        setScale(minScale);
+}
+
+void DynamicResolution::begin()
+{
+    timer.begin();
+}
+
+void DynamicResolution::end()
+{
+    timer.end();
+
+    if (!enabled)
+        return;
+
+    if (cooldown > 0) {
+        --cooldown;
+        return;
+    }
+
+    const float milliseconds = timer.getMilliseconds();
+    if (milliseconds > budget) {
+        underBudgetFrameCount = 0;
+        setScale(scale * std::sqrt(Headroom * budget / milliseconds));
+        return;
+    }
+
+    // Grows only if the next step is predicted to fit.
+    const float grown = scale + Step;
+    if (milliseconds * (grown * grown) / (scale * scale) < Headroom * budget) {
+        if (++underBudgetFrameCount >= GrowFrameCount) {
+            underBudgetFrameCount = 0;
+            setScale(grown);
+        }
+    } else {
+        underBudgetFrameCount = 0;
+    }
+}
+
+void DynamicResolution::setScale(float scale)
+{
+    // Rounded down, so that shrinking always gets under budget.
+    scale = std::clamp(std::floor(scale / Step + 0.001f) * Step, minScale, 1.f);
+    if (scale == this->scale)
+        return;
+
+    this->scale = scale;
+    cooldown = LatencyFrameCount;
+}
@@ -0,0 +1,63 @@
+#include "framebuffer.hpp"
+#include <glad/gl.h>
+#include "math/vector.hpp"
+#include "utils/assertion.hpp"
+
+Framebuffer::Framebuffer(const Vector2i& size, GLenum colorFormat)
+    : colorFormat{ colorFormat }
+    , size{ size }
+{
+    Assert(size.x > 0 && size.y > 0);
+
+    glCreateFramebuffers(1, &framebuffer);
+
+    createAttachments();
+}
+
+Framebuffer::~Framebuffer()
+{
+    destroyAttachments();
+
+    glDeleteFramebuffers(1, &framebuffer);
+}
+
+void Framebuffer::resize(const Vector2i& size)
+{
+    Assert(size.x > 0 && size.y > 0);
+
+    if (size == this->size)
+        return;
+
+    this->size = size;
+
+    destroyAttachments();
+    createAttachments();
+}
+
+void Framebuffer::bind() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void Framebuffer::createAttachments()
+{
+    glCreateTextures(GL_TEXTURE_2D, 1, &colorTexture);
+    glTextureStorage2D(colorTexture, 1, colorFormat, size.x, size.y);
+    glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, colorTexture, 0);
+
+    // Depth is kept in a texture rather than a renderbuffer so that later passes
+    // (e.g. the Hi-Z pyramid) can sample it.
+    glCreateTextures(GL_TEXTURE_2D, 1, &depthTexture);
+    glTextureStorage2D(depthTexture, 1, GL_DEPTH_COMPONENT32F, size.x, size.y);
+    glTextureParameteri(depthTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(depthTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glNamedFramebufferTexture(framebuffer, GL_DEPTH_ATTACHMENT, depthTexture, 0);
+
+    Assert(glCheckNamedFramebufferStatus(framebuffer, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+}
+
+void Framebuffer::destroyAttachments()
+{
+    glDeleteTextures(1, &depthTexture);
+    glDeleteTextures(1, &colorTexture);
+}
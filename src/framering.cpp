@@ -0,0 +1,41 @@
+#include "framering.hpp"
+#include <glad/gl.h>
+
+FrameRing::FrameRing()
+    : fences{}
+    , frame{ 0 }
+{
+}
+
+FrameRing::~FrameRing()
+{
+    for (GLsync fence : fences)
+        glDeleteSync(fence);
+}
+
+void FrameRing::advance()
+{
+    frame = (frame + 1) % FrameCount;
+    wait(fences[frame]);
+}
+
+void FrameRing::fence()
+{
+    glDeleteSync(fences[frame]);
+    fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void FrameRing::wait()
+{
+    for (GLsync& fence : fences)
+        wait(fence);
+}
+
+void FrameRing::wait(GLsync& fence)
+{
+    if (fence) {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
@@ -0,0 +1,174 @@
+#include "geometrypool.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glad/gl.h>
+#include "math/matrix.hpp"
+#include "mesh.hpp"
+#include "shader.hpp"
+#include "utils/assertion.hpp"
+
+static std::uint32_t packUnorm4x8(float x, float y, float z, float w)
+{
+    const auto pack = [](float f) {
+        return static_cast<std::uint32_t>(std::lround(std::clamp(f, 0.f, 1.f) * 255));
+    };
+
+    return pack(x) | pack(y) << 8 | pack(z) << 16 | pack(w) << 24;
+}
+
+// Round to nearest; denormals flush to zero, out of range values to infinity.
+static std::uint32_t packHalf(float f)
+{
+    const std::uint32_t bits = std::bit_cast<std::uint32_t>(f);
+    const std::uint32_t sign = (bits >> 16) & 0x8000;
+    const int exponent = static_cast<int>((bits >> 23) & 0xff) - 127 + 15;
+    const std::uint32_t mantissa = bits & 0x7fffff;
+
+    if (exponent <= 0)
+        return sign;
+    if (exponent >= 31)
+        return sign | 0x7c00;
+
+    const std::uint32_t half = sign | static_cast<std::uint32_t>(exponent) << 10 | mantissa >> 13;
+
+    return half + ((mantissa >> 12) & 1);
+}
+
+static std::uint32_t packHalf2x16(float x, float y)
+{
+    return packHalf(x) | packHalf(y) << 16;
+}
+
+GeometryPool::GeometryPool(int vertexCapacity, int indexCapacity, int drawCapacity, int modelCapacity)
+    : vertexCapacity{ vertexCapacity }
+    , indexCapacity{ indexCapacity }
+    , drawCapacity{ drawCapacity }
+    , modelCapacity{ modelCapacity }
+    , vertexCount{ 0 }
+    , indexCount{ 0 }
+{
+    Assert(vertexCapacity > 0 && indexCapacity > 0 && drawCapacity > 0 && modelCapacity > 0);
+
+    glCreateVertexArrays(1, &vertexArray);
+
+    glCreateBuffers(1, &vertexBuffer);
+    glNamedBufferStorage(vertexBuffer, vertexCapacity * VertexSize * sizeof(std::uint32_t), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    glCreateBuffers(1, &indexBuffer);
+    glNamedBufferStorage(indexBuffer, indexCapacity * sizeof(GLuint), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    glCreateBuffers(1, &commandBuffer);
+    glNamedBufferStorage(commandBuffer, drawCapacity * sizeof(DrawCommand), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    glCreateBuffers(1, &recordBuffer);
+    glNamedBufferStorage(recordBuffer, drawCapacity * sizeof(DrawRecord), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    glCreateBuffers(1, &modelBuffer);
+    glNamedBufferStorage(modelBuffer, modelCapacity * sizeof(Matrix4f), nullptr, GL_DYNAMIC_STORAGE_BIT);
+}
+
+GeometryPool::~GeometryPool()
+{
+    glDeleteBuffers(1, &modelBuffer);
+    glDeleteBuffers(1, &recordBuffer);
+    glDeleteBuffers(1, &commandBuffer);
+    glDeleteBuffers(1, &indexBuffer);
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteVertexArrays(1, &vertexArray);
+}
+
+int GeometryPool::addMesh(std::span<const Mesh::Vertex> vertices, std::span<const unsigned int> indices)
+{
+    Assert(vertices.size() > 0 && indices.size() > 0);
+    Assert(vertexCount + static_cast<int>(vertices.size()) <= vertexCapacity);
+    Assert(indexCount + static_cast<int>(indices.size()) <= indexCapacity);
+
+    std::vector<std::uint32_t> data;
+    data.reserve(vertices.size() * VertexSize);
+
+    for (const Mesh::Vertex& vertex : vertices) {
+        data.push_back(std::bit_cast<std::uint32_t>(vertex.position.x));
+        data.push_back(std::bit_cast<std::uint32_t>(vertex.position.y));
+        data.push_back(std::bit_cast<std::uint32_t>(vertex.position.z));
+        data.push_back(packUnorm4x8(vertex.color.x, vertex.color.y, vertex.color.z, 1));
+        data.push_back(packHalf2x16(vertex.texCoords.x, vertex.texCoords.y));
+    }
+
+    glNamedBufferSubData(vertexBuffer, vertexCount * VertexSize * sizeof(std::uint32_t), data.size() * sizeof(std::uint32_t), data.data());
+    glNamedBufferSubData(indexBuffer, indexCount * sizeof(GLuint), indices.size_bytes(), indices.data());
+
+    meshes.push_back(MeshRange{
+        .firstIndex = static_cast<GLuint>(indexCount),
+        .indexCount = static_cast<GLuint>(indices.size()),
+        .baseVertex = static_cast<GLuint>(vertexCount) });
+
+    vertexCount += vertices.size();
+    indexCount += indices.size();
+
+    return meshes.size() - 1;
+}
+
+void GeometryPool::clearDraws()
+{
+    commands.clear();
+    records.clear();
+    models.clear();
+}
+
+void GeometryPool::addDraw(int mesh, std::span<const Matrix4f> models)
+{
+    Assert(mesh >= 0 && mesh < static_cast<int>(meshes.size()));
+    Assert(static_cast<int>(commands.size()) < drawCapacity);
+    Assert(static_cast<int>(this->models.size() + models.size()) <= modelCapacity);
+
+    if (models.empty())
+        return;
+
+    const MeshRange& range = meshes[mesh];
+
+    commands.push_back(DrawCommand{
+        .count = range.indexCount,
+        .instanceCount = static_cast<GLuint>(models.size()),
+        .first = range.firstIndex,
+        .baseInstance = 0 });
+
+    records.push_back(DrawRecord{
+        .baseVertex = range.baseVertex,
+        .firstModel = static_cast<GLuint>(this->models.size()) });
+
+    this->models.insert(this->models.end(), models.begin(), models.end());
+}
+
+void GeometryPool::draw(Shader& shader, int viewCount) const
+{
+    Assert(viewCount > 0);
+
+    if (commands.empty())
+        return;
+
+    if (viewCount == 1) {
+        glNamedBufferSubData(commandBuffer, 0, commands.size() * sizeof(DrawCommand), commands.data());
+    } else {
+        std::vector<DrawCommand> viewCommands = commands;
+        for (DrawCommand& command : viewCommands)
+            command.instanceCount *= viewCount;
+
+        glNamedBufferSubData(commandBuffer, 0, viewCommands.size() * sizeof(DrawCommand), viewCommands.data());
+    }
+    glNamedBufferSubData(recordBuffer, 0, records.size() * sizeof(DrawRecord), records.data());
+    glNamedBufferSubData(modelBuffer, 0, models.size() * sizeof(Matrix4f), models.data());
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, modelBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, vertexBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, indexBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 10, recordBuffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+
+    shader.bind();
+    glBindVertexArray(vertexArray);
+    glMultiDrawArraysIndirect(GL_TRIANGLES, nullptr, commands.size(), 0);
+}
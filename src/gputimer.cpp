@@ -0,0 +1,44 @@
+#include "gputimer.hpp"
+#include <glad/gl.h>
+
+GpuTimer::GpuTimer()
+    : pending{}
+    , index{ 0 }
+    , milliseconds{ 0 }
+{
+    glCreateQueries(GL_TIMESTAMP, queries.size(), queries.data());
+}
+
+GpuTimer::~GpuTimer()
+{
+    glDeleteQueries(queries.size(), queries.data());
+}
+
+void GpuTimer::begin()
+{
+    // Collect the oldest measurement before its queries are reused.
+    if (pending[index]) {
+        GLint available;
+        glGetQueryObjectiv(queries[2 * index + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if (available) {
+            GLuint64 start, stop;
+            glGetQueryObjectui64v(queries[2 * index], GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(queries[2 * index + 1], GL_QUERY_RESULT, &stop);
+
+            milliseconds = (stop - start) / 1e6f;
+        }
+
+        pending[index] = false;
+    }
+
+    glQueryCounter(queries[2 * index], GL_TIMESTAMP);
+}
+
+void GpuTimer::end()
+{
+    glQueryCounter(queries[2 * index + 1], GL_TIMESTAMP);
+
+    pending[index] = true;
+    index = (index + 1) % FrameCount;
+}
@@ -0,0 +1,202 @@
+#include "imguirenderer.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <glad/gl.h>
+#include <imgui.h>
+#include "math/vector.hpp"
+#include "shader.hpp"
+#include "utils/assertion.hpp"
+
+static constexpr GLenum IndexType = sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+ImGuiRenderer::ImGuiRenderer(int vertexCapacity, int indexCapacity)
+    : shader{ Shader::loadFromFile("shaders/imgui.vs.glsl", "shaders/imgui.fs.glsl") }
+    , vertexCapacity{ vertexCapacity }
+    , indexCapacity{ indexCapacity }
+{
+    Assert(vertexCapacity > 0 && indexCapacity > 0);
+
+    ImGuiIO& io = ImGui::GetIO();
+    io.BackendRendererName = "cube";
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;
+
+    glCreateVertexArrays(1, &vertexArray);
+
+    glEnableVertexArrayAttrib(vertexArray, 0);
+    glVertexArrayAttribFormat(vertexArray, 0, 2, GL_FLOAT, GL_FALSE, offsetof(ImDrawVert, pos));
+    glVertexArrayAttribBinding(vertexArray, 0, 0);
+
+    glEnableVertexArrayAttrib(vertexArray, 1);
+    glVertexArrayAttribFormat(vertexArray, 1, 2, GL_FLOAT, GL_FALSE, offsetof(ImDrawVert, uv));
+    glVertexArrayAttribBinding(vertexArray, 1, 0);
+
+    glEnableVertexArrayAttrib(vertexArray, 2);
+    glVertexArrayAttribFormat(vertexArray, 2, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(ImDrawVert, col));
+    glVertexArrayAttribBinding(vertexArray, 2, 0);
+
+    createBuffer();
+
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &fontTexture);
+    glTextureStorage2D(fontTexture, 1, GL_RGBA8, width, height);
+    glTextureSubImage2D(fontTexture, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glTextureParameteri(fontTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(fontTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    io.Fonts->SetTexID(ImTextureID(static_cast<std::intptr_t>(fontTexture)));
+}
+
+ImGuiRenderer::~ImGuiRenderer()
+{
+    ImGuiIO& io = ImGui::GetIO();
+    io.Fonts->SetTexID(ImTextureID{});
+    io.BackendRendererName = nullptr;
+    io.BackendFlags &= ~ImGuiBackendFlags_RendererHasVtxOffset;
+
+    destroyBuffer();
+
+    glDeleteTextures(1, &fontTexture);
+    glDeleteVertexArrays(1, &vertexArray);
+}
+
+void ImGuiRenderer::render(const ImDrawData& drawData)
+{
+    Assert(shader);
+
+    const Vector2i framebufferSize{
+        static_cast<int>(drawData.DisplaySize.x * drawData.FramebufferScale.x),
+        static_cast<int>(drawData.DisplaySize.y * drawData.FramebufferScale.y)
+    };
+    if (framebufferSize.x <= 0 || framebufferSize.y <= 0 || drawData.TotalIdxCount == 0)
+        return;
+
+    // Rare, the whole ring is reallocated once the GPU is done with it.
+    if (drawData.TotalVtxCount > vertexCapacity || drawData.TotalIdxCount > indexCapacity) {
+        destroyBuffer();
+        vertexCapacity = std::max(vertexCapacity, static_cast<int>(std::bit_ceil(static_cast<unsigned>(drawData.TotalVtxCount))));
+        indexCapacity = std::max(indexCapacity, static_cast<int>(std::bit_ceil(static_cast<unsigned>(drawData.TotalIdxCount))));
+        createBuffer();
+    }
+
+    ring.advance();
+
+    const int frame = ring.getFrame();
+    const int vertexBase = frame * vertexCapacity;
+    const int indexBase = frame * indexCapacity;
+    ImDrawIdx* const frameIndices = static_cast<ImDrawIdx*>(indices) + indexBase;
+
+    int vertexCount = 0;
+    int indexCount = 0;
+    for (int i = 0; i < drawData.CmdListsCount; ++i) {
+        const ImDrawList* list = drawData.CmdLists[i];
+        std::memcpy(vertices + vertexBase + vertexCount, list->VtxBuffer.Data, list->VtxBuffer.Size * sizeof(ImDrawVert));
+        std::memcpy(frameIndices + indexCount, list->IdxBuffer.Data, list->IdxBuffer.Size * sizeof(ImDrawIdx));
+        vertexCount += list->VtxBuffer.Size;
+        indexCount += list->IdxBuffer.Size;
+    }
+
+    setupState(drawData, framebufferSize);
+
+    const ImVec2 clipOffset = drawData.DisplayPos;
+    const ImVec2 clipScale = drawData.FramebufferScale;
+    GLuint boundTexture = 0;
+
+    vertexCount = 0;
+    indexCount = 0;
+    for (int i = 0; i < drawData.CmdListsCount; ++i) {
+        const ImDrawList* list = drawData.CmdLists[i];
+
+        for (const ImDrawCmd& command : list->CmdBuffer) {
+            if (command.UserCallback) {
+                if (command.UserCallback == ImDrawCallback_ResetRenderState) {
+                    setupState(drawData, framebufferSize);
+                    boundTexture = 0;
+                } else {
+                    command.UserCallback(list, &command);
+                }
+                continue;
+            }
+
+            const float minX = std::max((command.ClipRect.x - clipOffset.x) * clipScale.x, 0.f);
+            const float minY = std::max((command.ClipRect.y - clipOffset.y) * clipScale.y, 0.f);
+            const float maxX = std::min((command.ClipRect.z - clipOffset.x) * clipScale.x, static_cast<float>(framebufferSize.x));
+            const float maxY = std::min((command.ClipRect.w - clipOffset.y) * clipScale.y, static_cast<float>(framebufferSize.y));
+            if (maxX <= minX || maxY <= minY)
+                continue;
+
+            // Scissor origin is bottom left.
+            glScissor(static_cast<int>(minX), static_cast<int>(framebufferSize.y - maxY),
+                static_cast<int>(maxX - minX), static_cast<int>(maxY - minY));
+
+            const GLuint texture = static_cast<GLuint>(std::intptr_t(command.GetTexID()));
+            if (texture != boundTexture) {
+                glBindTextureUnit(0, texture);
+                boundTexture = texture;
+            }
+
+            const GLintptr offset = indexOffset + (indexBase + indexCount + command.IdxOffset) * sizeof(ImDrawIdx);
+            glDrawElementsBaseVertex(GL_TRIANGLES, command.ElemCount, IndexType, reinterpret_cast<const GLvoid*>(offset), vertexBase + vertexCount + command.VtxOffset);
+        }
+
+        vertexCount += list->VtxBuffer.Size;
+        indexCount += list->IdxBuffer.Size;
+    }
+
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+
+    ring.fence();
+}
+
+void ImGuiRenderer::createBuffer()
+{
+    indexOffset = FrameRing::FrameCount * vertexCapacity * sizeof(ImDrawVert);
+    const GLsizeiptr size = indexOffset + FrameRing::FrameCount * indexCapacity * sizeof(ImDrawIdx);
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    // Vertices of every region first, then indices.
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, size, nullptr, flags);
+    void* data = glMapNamedBufferRange(buffer, 0, size, flags);
+    vertices = static_cast<ImDrawVert*>(data);
+    indices = static_cast<std::byte*>(data) + indexOffset;
+
+    glVertexArrayVertexBuffer(vertexArray, 0, buffer, 0, sizeof(ImDrawVert));
+    glVertexArrayElementBuffer(vertexArray, buffer);
+}
+
+void ImGuiRenderer::destroyBuffer()
+{
+    ring.wait();
+
+    glUnmapNamedBuffer(buffer);
+    glDeleteBuffers(1, &buffer);
+}
+
+void ImGuiRenderer::setupState(const ImDrawData& drawData, const Vector2i& framebufferSize)
+{
+    glEnable(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_SCISSOR_TEST);
+
+    glViewport(0, 0, framebufferSize.x, framebufferSize.y);
+
+    const Vector2f scale{ 2 / drawData.DisplaySize.x, -2 / drawData.DisplaySize.y };
+    const Vector2f translate{ -1 - drawData.DisplayPos.x * scale.x, 1 - drawData.DisplayPos.y * scale.y };
+    shader.setUniform("scale", scale);
+    shader.setUniform("translate", translate);
+    shader.bind();
+
+    glBindVertexArray(vertexArray);
+}
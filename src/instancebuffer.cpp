@@ -0,0 +1,45 @@
+#include "instancebuffer.hpp"
+#include <span>
+#include <glad/gl.h>
+#include "math/matrix.hpp"
+#include "utils/assertion.hpp"
+
+InstanceBuffer::InstanceBuffer(int capacity)
+    : capacity{ capacity }
+{
+    Assert(capacity > 0);
+
+    glCreateBuffers(1, &modelBuffer);
+    glNamedBufferStorage(modelBuffer, capacity * sizeof(Matrix4f), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    glCreateBuffers(1, &indexBuffer);
+    glNamedBufferStorage(indexBuffer, capacity * sizeof(GLuint), nullptr, GL_DYNAMIC_STORAGE_BIT);
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+    glDeleteBuffers(1, &indexBuffer);
+    glDeleteBuffers(1, &modelBuffer);
+}
+
+void InstanceBuffer::setModels(std::span<const Matrix4f> models)
+{
+    Assert(static_cast<int>(models.size()) <= capacity);
+
+    if (!models.empty())
+        glNamedBufferSubData(modelBuffer, 0, models.size_bytes(), models.data());
+}
+
+void InstanceBuffer::setIndices(std::span<const unsigned int> indices)
+{
+    Assert(static_cast<int>(indices.size()) <= capacity);
+
+    if (!indices.empty())
+        glNamedBufferSubData(indexBuffer, 0, indices.size_bytes(), indices.data());
+}
+
+void InstanceBuffer::bind() const
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, modelBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, indexBuffer);
+}
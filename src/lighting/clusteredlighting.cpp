@@ -0,0 +1,81 @@
+#include "lighting/clusteredlighting.hpp"
+#include <cmath>
+#include <span>
+#include <glad/gl.h>
+#include "math/vector.hpp"
+#include "shader.hpp"
+#include "utils/assertion.hpp"
+
+static constexpr int ClusterCount = ClusteredLighting::ClusterCountX * ClusteredLighting::ClusterCountY * ClusteredLighting::ClusterCountZ;
+static constexpr int GroupSize = 64;
+
+static_assert(sizeof(ClusteredLighting::PointLight) == 32);
+static_assert(ClusterCount % GroupSize == 0);
+
+ClusteredLighting::ClusteredLighting(int capacity)
+    : shader{ Shader::loadFromFile("shaders/clusters.cs.glsl") }
+    , capacity{ capacity }
+    , lightCount{ 0 }
+    , ambient{ 0.2f }
+    , zNear{ 1 }
+    , zFar{ 2 }
+{
+    Assert(capacity > 0);
+
+    glCreateBuffers(1, &lightBuffer);
+    glNamedBufferStorage(lightBuffer, capacity * sizeof(PointLight), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    // Per cluster light count; lists live at a fixed offset in the index buffer.
+    glCreateBuffers(1, &clusterBuffer);
+    glNamedBufferStorage(clusterBuffer, ClusterCount * sizeof(GLuint), nullptr, 0);
+
+    glCreateBuffers(1, &lightIndexBuffer);
+    glNamedBufferStorage(lightIndexBuffer, ClusterCount * MaxLightsPerCluster * sizeof(GLuint), nullptr, 0);
+}
+
+ClusteredLighting::~ClusteredLighting()
+{
+    glDeleteBuffers(1, &lightIndexBuffer);
+    glDeleteBuffers(1, &clusterBuffer);
+    glDeleteBuffers(1, &lightBuffer);
+}
+
+void ClusteredLighting::update(std::span<const PointLight> lights, float fovY, float aspect, float zNear, float zFar)
+{
+    Assert(shader && static_cast<int>(lights.size()) <= capacity);
+    Assert(fovY > 0 && aspect > 0 && 0 < zNear && zNear < zFar);
+
+    lightCount = lights.size();
+    this->zNear = zNear;
+    this->zFar = zFar;
+    tanHalfFov = Vector2f{ std::tan(0.5f * fovY) * aspect, std::tan(0.5f * fovY) };
+
+    if (!lights.empty())
+        glNamedBufferSubData(lightBuffer, 0, lights.size_bytes(), lights.data());
+
+    shader.setUniform("lightCount", lightCount);
+    shader.setUniform("tanHalfFovY", tanHalfFov.y);
+    shader.setUniform("aspect", aspect);
+    shader.setUniform("zNear", zNear);
+    shader.setUniform("zFar", zFar);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, lightBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, clusterBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, lightIndexBuffer);
+
+    shader.bind();
+    glDispatchCompute(ClusterCount / GroupSize, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void ClusteredLighting::apply(Shader& shader) const
+{
+    shader.setUniform("ambient", ambient);
+    shader.setUniform("zNear", zNear);
+    shader.setUniform("zFar", zFar);
+    shader.setUniform("tanHalfFov", tanHalfFov);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, lightBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, clusterBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, lightIndexBuffer);
+}
@@ -0,0 +1,139 @@
+#include "lod/impostor.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <span>
+#include <glad/gl.h>
+#include "math/matrix.hpp"
+#include "math/vector.hpp"
+#include "mesh.hpp"
+#include "shader.hpp"
+#include "utils/assertion.hpp"
+
+Impostor::Impostor(const Mesh& mesh, int capacity, int frameCount, int frameSize)
+    : capacity{ capacity }
+    , frameCount{ frameCount }
+    , frameSize{ frameSize }
+    , center{ mesh.getBounds().getCenter() }
+    , radius{ length(mesh.getBounds().getExtents()) }
+    , instanceCount{ 0 }
+{
+    Assert(capacity > 0 && frameCount > 0 && frameSize > 0);
+
+    // Coarse mips would blend neighbouring frames, so the chain stops at 8x8.
+    const int size = frameCount * frameSize;
+    const int levelCount = std::max(static_cast<int>(std::bit_width(static_cast<unsigned int>(frameSize))) - 3, 1);
+
+    for (GLuint* texture : { &albedoTexture, &normalTexture }) {
+        glCreateTextures(GL_TEXTURE_2D, 1, texture);
+        glTextureStorage2D(*texture, levelCount, GL_RGBA8, size, size);
+        glTextureParameteri(*texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTextureParameteri(*texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameteri(*texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(*texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    // Quads are generated from gl_VertexID.
+    glCreateVertexArrays(1, &vertexArray);
+
+    glCreateBuffers(1, &instanceBuffer);
+    glNamedBufferStorage(instanceBuffer, capacity * sizeof(Instance), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    baked = bake(mesh);
+}
+
+Impostor::~Impostor()
+{
+    glDeleteBuffers(1, &instanceBuffer);
+    glDeleteVertexArrays(1, &vertexArray);
+    glDeleteTextures(1, &normalTexture);
+    glDeleteTextures(1, &albedoTexture);
+}
+
+void Impostor::setInstances(std::span<const Matrix4f> models, std::span<const float> fades)
+{
+    Assert(models.size() == fades.size() && static_cast<int>(models.size()) <= capacity);
+
+    instances.clear();
+    for (std::size_t i = 0; i < models.size(); ++i)
+        instances.push_back(Instance{ .model = models[i], .fade = fades[i], .padding = {} });
+
+    instanceCount = static_cast<int>(instances.size());
+    if (instanceCount > 0)
+        glNamedBufferSubData(instanceBuffer, 0, instanceCount * sizeof(Instance), instances.data());
+}
+
+void Impostor::draw(Shader& shader, int viewCount) const
+{
+    Assert(baked && viewCount > 0);
+
+    if (instanceCount == 0)
+        return;
+
+    shader.setUniform("center", center);
+    shader.setUniform("radius", radius);
+    shader.setUniform("frameCount", frameCount);
+    shader.bind();
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 11, instanceBuffer);
+    glBindTextureUnit(0, albedoTexture);
+    glBindTextureUnit(1, normalTexture);
+
+    glBindVertexArray(vertexArray);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instanceCount * viewCount);
+}
+
+bool Impostor::bake(const Mesh& mesh)
+{
+    Shader shader = Shader::loadFromFile("shaders/impostorbake.vs.glsl", "shaders/impostorbake.fs.glsl");
+    if (!shader)
+        return false;
+
+    const int size = frameCount * frameSize;
+
+    GLuint depthBuffer;
+    glCreateRenderbuffers(1, &depthBuffer);
+    glNamedRenderbufferStorage(depthBuffer, GL_DEPTH_COMPONENT32F, size, size);
+
+    GLuint framebuffer;
+    glCreateFramebuffers(1, &framebuffer);
+    glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, albedoTexture, 0);
+    glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT1, normalTexture, 0);
+    glNamedFramebufferRenderbuffer(framebuffer, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+    const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glNamedFramebufferDrawBuffers(framebuffer, 2, drawBuffers);
+
+    Assert(glCheckNamedFramebufferStatus(framebuffer, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+    // Zero alpha marks texels outside of the mesh.
+    const float clearColor[] = { 0, 0, 0, 0 };
+    const float clearDepth = 1;
+    glClearNamedFramebufferfv(framebuffer, GL_COLOR, 0, clearColor);
+    glClearNamedFramebufferfv(framebuffer, GL_COLOR, 1, clearColor);
+    glClearNamedFramebufferfv(framebuffer, GL_DEPTH, 0, &clearDepth);
+
+    shader.setUniform("center", center);
+    shader.setUniform("radius", radius);
+    shader.setUniform("frameCount", frameCount);
+    shader.bind();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    for (int j = 0; j < frameCount; ++j)
+        for (int i = 0; i < frameCount; ++i) {
+            shader.setUniform("frameIndex", j * frameCount + i);
+            glViewport(i * frameSize, j * frameSize, frameSize, frameSize);
+            mesh.draw();
+        }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &depthBuffer);
+
+    glGenerateTextureMipmap(albedoTexture);
+    glGenerateTextureMipmap(normalTexture);
+
+    return true;
+}
@@ -0,0 +1,103 @@
+#include "lod/lodselector.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include "math/boundingbox.hpp"
+#include "math/matrix.hpp"
+#include "math/vector.hpp"
+#include "utils/assertion.hpp"
+#include "utils/threadpool.hpp"
+
+static constexpr float MinBias = -4;
+static constexpr float MaxBias = 8;
+static constexpr float BiasStep = 0.125f;
+
+LodSelector::LodSelector(ThreadPool& threadPool)
+    : threadPool{ threadPool }
+    , pixelsPerUnit{ 1 }
+    , threshold{ 1 }
+    , hysteresis{ 0.25f }
+    , bias{ 0 }
+    , triangleBudget{ 0 }
+    , triangleCount{ 0 }
+    , lastTriangleCount{ 0 }
+{
+}
+
+void LodSelector::setProjection(float fovY, int viewportHeight)
+{
+    Assert(fovY > 0 && viewportHeight > 0);
+
+    // Size in pixels of one unit seen at distance one.
+    pixelsPerUnit = viewportHeight / (2 * std::tan(0.5f * fovY));
+}
+
+void LodSelector::beginFrame()
+{
+    triangleCount = 0;
+}
+
+void LodSelector::endFrame()
+{
+    lastTriangleCount = triangleCount;
+
+    if (triangleBudget <= 0)
+        return;
+
+    // Coarsen quickly when over budget, refine only once well under it.
+    if (lastTriangleCount > triangleBudget)
+        bias = std::min(bias + BiasStep, MaxBias);
+    else if (lastTriangleCount < 0.85f * triangleBudget)
+        bias = std::max(bias - 0.5f * BiasStep, MinBias);
+}
+
+void LodSelector::select(std::span<const Level> levels, const BoundingBox& bounds, std::span<const Matrix4f> models, std::span<std::uint8_t> lods)
+{
+    Assert(!levels.empty() && levels.size() <= 256 && lods.size() >= models.size());
+
+    const Vector3f center = bounds.getCenter();
+    const float radius = length(bounds.getExtents());
+    const float limit = threshold * std::exp2(bias);
+    const int coarsest = levels.size() - 1;
+
+    static constexpr int BatchSize = 512;
+    const int batchCount = (static_cast<int>(models.size()) + BatchSize - 1) / BatchSize;
+
+    threadPool.parallelFor(batchCount, [&](int batch) {
+        const std::size_t end = std::min(models.size(), static_cast<std::size_t>(batch + 1) * BatchSize);
+        int batchTriangleCount = 0;
+
+        for (std::size_t i = batch * BatchSize; i < end; ++i) {
+            const Matrix4f& model = models[i];
+            const std::array<float, 16>& m = model.values;
+
+            const Vector4f viewCenter = model * Vector4f{ center, 1 };
+            const float scale = std::sqrt(std::max({
+                m[0] * m[0] + m[1] * m[1] + m[2] * m[2],
+                m[4] * m[4] + m[5] * m[5] + m[6] * m[6],
+                m[8] * m[8] + m[9] * m[9] + m[10] * m[10] }));
+
+            // Distance to the nearest point of the bounding sphere, clamped so
+            // that instances around the camera get the finest level.
+            const float distance = std::max(length(Vector3f{ viewCenter.x, viewCenter.y, viewCenter.z }) - scale * radius, 1e-3f);
+            const float errorScale = scale * pixelsPerUnit / distance;
+
+            int lod = std::min<int>(lods[i], coarsest);
+
+            if (levels[lod].error * errorScale > limit * (1 + hysteresis)) {
+                while (lod > 0 && levels[lod].error * errorScale > limit)
+                    --lod;
+            } else {
+                while (lod < coarsest && levels[lod + 1].error * errorScale <= limit * (1 - hysteresis))
+                    ++lod;
+            }
+
+            lods[i] = lod;
+            batchTriangleCount += levels[lod].triangleCount;
+        }
+
+        triangleCount += batchTriangleCount;
+    });
+}
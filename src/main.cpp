@@ -1,112 +1,1273 @@
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <numbers>
+#include <random>
 #include <ratio>
+#include <span>
+#include <string>
+#include <string_view>
 #include <thread>
+#include <utility>
+#include <vector>
+#include <glad/gl.h>
 #include <imgui.h>
+#include <spdlog/spdlog.h>
+#include "culling/occlusionculler.hpp"
+#include "culling/occlusionqueries.hpp"
+#include "culling/occlusionrasterizer.hpp"
+#include "debugdraw.hpp"
+#include "deletionqueue.hpp"
+#include "dynamicresolution.hpp"
+#include "framebuffer.hpp"
+#include "geometrypool.hpp"
+#include "gputimer.hpp"
+#include "instancebuffer.hpp"
+#include "lighting/clusteredlighting.hpp"
+#include "lod/impostor.hpp"
+#include "lod/lodselector.hpp"
+#include "math/boundingbox.hpp"
 #include "math/math.hpp"
 #include "math/matrix.hpp"
 #include "math/vector.hpp"
 #include "mesh.hpp"
+#include "meshbatcher.hpp"
+#include "multiview.hpp"
+#include "platform.hpp"
+#include "postprocessing.hpp"
+#include "rendergraph.hpp"
 #include "shader.hpp"
+#include "shaderlibrary.hpp"
+#include "softwarerenderer.hpp"
+#include "uniformring.hpp"
+#include "utils/threadpool.hpp"
 #include "window.hpp"
 
 using FrameTime = std::chrono::duration<int, std::ratio<1, 30>>;
 
-void render(const Vector2i& size, Shader& shader, const Mesh& mesh)
+const Mesh::Vertex CubeVertices[] = {
+    // Front
+    { .position = Vector3f{ -1, -1, 1 }, .color = Vector3f{ 1, 0, 0 }, .texCoords = Vector2f{ 0, 0 } },
+    { .position = Vector3f{ 1, -1, 1 }, .color = Vector3f{ 1, 0, 0 }, .texCoords = Vector2f{ 1, 0 } },
+    { .position = Vector3f{ 1, 1, 1 }, .color = Vector3f{ 1, 0, 0 }, .texCoords = Vector2f{ 1, 1 } },
+    { .position = Vector3f{ -1, 1, 1 }, .color = Vector3f{ 1, 0, 0 }, .texCoords = Vector2f{ 0, 1 } },
+    // Right
+    { .position = Vector3f{ 1, -1, 1 }, .color = Vector3f{ 0, 1, 0 }, .texCoords = Vector2f{ 0, 0 } },
+    { .position = Vector3f{ 1, -1, -1 }, .color = Vector3f{ 0, 1, 0 }, .texCoords = Vector2f{ 1, 0 } },
+    { .position = Vector3f{ 1, 1, -1 }, .color = Vector3f{ 0, 1, 0 }, .texCoords = Vector2f{ 1, 1 } },
+    { .position = Vector3f{ 1, 1, 1 }, .color = Vector3f{ 0, 1, 0 }, .texCoords = Vector2f{ 0, 1 } },
+    // Back
+    { .position = Vector3f{ 1, -1, -1 }, .color = Vector3f{ 0, 0, 1 }, .texCoords = Vector2f{ 0, 0 } },
+    { .position = Vector3f{ -1, -1, -1 }, .color = Vector3f{ 0, 0, 1 }, .texCoords = Vector2f{ 1, 0 } },
+    { .position = Vector3f{ -1, 1, -1 }, .color = Vector3f{ 0, 0, 1 }, .texCoords = Vector2f{ 1, 1 } },
+    { .position = Vector3f{ 1, 1, -1 }, .color = Vector3f{ 0, 0, 1 }, .texCoords = Vector2f{ 0, 1 } },
+    // Left
+    { .position = Vector3f{ -1, -1, -1 }, .color = Vector3f{ 0, 1, 1 }, .texCoords = Vector2f{ 0, 0 } },
+    { .position = Vector3f{ -1, -1, 1 }, .color = Vector3f{ 0, 1, 1 }, .texCoords = Vector2f{ 1, 0 } },
+    { .position = Vector3f{ -1, 1, 1 }, .color = Vector3f{ 0, 1, 1 }, .texCoords = Vector2f{ 1, 1 } },
+    { .position = Vector3f{ -1, 1, -1 }, .color = Vector3f{ 0, 1, 1 }, .texCoords = Vector2f{ 0, 1 } },
+    // Top
+    { .position = Vector3f{ -1, 1, 1 }, .color = Vector3f{ 1, 1, 0 }, .texCoords = Vector2f{ 0, 0 } },
+    { .position = Vector3f{ 1, 1, 1 }, .color = Vector3f{ 1, 1, 0 }, .texCoords = Vector2f{ 1, 0 } },
+    { .position = Vector3f{ 1, 1, -1 }, .color = Vector3f{ 1, 1, 0 }, .texCoords = Vector2f{ 1, 1 } },
+    { .position = Vector3f{ -1, 1, -1 }, .color = Vector3f{ 1, 1, 0 }, .texCoords = Vector2f{ 0, 1 } },
+    // Bottom
+    { .position = Vector3f{ -1, -1, -1 }, .color = Vector3f{ 1, 0, 1 }, .texCoords = Vector2f{ 0, 0 } },
+    { .position = Vector3f{ 1, -1, -1 }, .color = Vector3f{ 1, 0, 1 }, .texCoords = Vector2f{ 1, 0 } },
+    { .position = Vector3f{ 1, -1, 1 }, .color = Vector3f{ 1, 0, 1 }, .texCoords = Vector2f{ 1, 1 } },
+    { .position = Vector3f{ -1, -1, 1 }, .color = Vector3f{ 1, 0, 1 }, .texCoords = Vector2f{ 0, 1 } }
+};
+
+const unsigned int CubeIndices[] = {
+    // Front
+    0, 1, 2, 2, 3, 0,
+    // Right
+    4, 5, 6, 6, 7, 4,
+    // Back
+    8, 9, 10, 10, 11, 8,
+    // Left
+    12, 13, 14, 14, 15, 12,
+    // Top
+    16, 17, 18, 18, 19, 16,
+    // Bottom
+    20, 21, 22, 22, 23, 20
+};
+
+constexpr int FieldSize = 64;
+constexpr int MaxLightCount = 1024;
+constexpr int SphereRowCount = 8;
+constexpr int SphereColumnCount = 24;
+constexpr int SphereSubdivisions[] = { 16, 8, 4, 2, 1 };
+constexpr int LargeSphereSubdivisions = 96;
+constexpr int MaxSecondaryWindowCount = 3;
+constexpr int HeadlessFrameCount = 120;
+
+// Features of the scene programs, bit i for keyword i.
+constexpr std::string_view SceneKeywords[] = { "FACE_BORDERS", MultiView::Keyword };
+constexpr std::uint32_t FaceBorders = 1 << 0;
+constexpr std::uint32_t MultipleViews = 1 << 1;
+
+struct MeshData {
+    std::vector<Mesh::Vertex> vertices;
+    std::vector<unsigned int> indices;
+};
+
+// Unit sphere made of the six cube faces, each subdivided into a grid and
+// pushed out onto the sphere.
+MeshData createCubeSphere(int subdivisions)
 {
-    static float fovY = 50;
-    ImGui::SliderFloat("fovY", &fovY, 5, 175);
+    MeshData data;
+
+    for (int face = 0; face < 6; ++face) {
+        const Mesh::Vertex& origin = CubeVertices[4 * face];
+        const Vector3f u = CubeVertices[4 * face + 1].position - origin.position;
+        const Vector3f v = CubeVertices[4 * face + 3].position - origin.position;
+        const unsigned int first = data.vertices.size();
+
+        for (int j = 0; j <= subdivisions; ++j)
+            for (int i = 0; i <= subdivisions; ++i) {
+                const Vector2f texCoords{ i / static_cast<float>(subdivisions), j / static_cast<float>(subdivisions) };
+                const Vector3f position = origin.position + texCoords.x * u + texCoords.y * v;
+
+                data.vertices.push_back({ .position = normalize(position), .color = origin.color, .texCoords = texCoords });
+            }
+
+        for (int j = 0; j < subdivisions; ++j)
+            for (int i = 0; i < subdivisions; ++i) {
+                const unsigned int a = first + j * (subdivisions + 1) + i;
+                const unsigned int b = a + 1;
+                const unsigned int c = b + subdivisions + 1;
+                const unsigned int d = a + subdivisions + 1;
+
+                data.indices.insert(data.indices.end(), { a, b, c, c, d, a });
+            }
+    }
+
+    return data;
+}
+
+// Largest distance between a subdivided face and the sphere, approximated
+// from the angle spanned by the diagonal of a grid cell.
+float getCubeSphereError(int subdivisions)
+{
+    return 1 - std::cos(std::numbers::sqrt2_v<float> * std::numbers::pi_v<float> / (4 * subdivisions));
+}
+
+struct Spheres {
+    std::vector<std::unique_ptr<Mesh>> meshes;
+    std::vector<LodSelector::Level> levels;
+    BoundingBox bounds;
+    std::vector<Matrix4f> models;
+    std::vector<std::uint8_t> lods;
+    std::vector<unsigned int> indices;
+    std::vector<int> counts;
+    InstanceBuffer instances;
+    GeometryPool pool;
+    std::vector<int> poolMeshes;
+    std::vector<Matrix4f> sortedModels;
+    std::unique_ptr<Impostor> impostor;
+    std::vector<std::uint8_t> meshed;
+    std::vector<Matrix4f> impostorModels;
+    std::vector<float> impostorFades;
+
+    Spheres()
+        : instances{ SphereRowCount * SphereColumnCount }
+        , pool{ 4096, 16384, std::size(SphereSubdivisions), SphereRowCount * SphereColumnCount }
+    {
+        for (int subdivisions : SphereSubdivisions) {
+            const MeshData data = createCubeSphere(subdivisions);
+
+            meshes.push_back(std::make_unique<Mesh>(data.vertices, data.indices));
+            poolMeshes.push_back(pool.addMesh(data.vertices, data.indices));
+            levels.push_back({ .error = getCubeSphereError(subdivisions), .triangleCount = static_cast<int>(data.indices.size() / 3) });
+        }
+
+        bounds = meshes.front()->getBounds();
+
+        for (int j = 0; j < SphereRowCount; ++j)
+            for (int i = 0; i < SphereColumnCount; ++i) {
+                const Vector3f position{ 0.75f * (i - SphereColumnCount / 2), -2, -4 - 1.75f * j };
+                models.push_back(Matrix4f::translate(position) * Matrix4f::scale(0.35f));
+            }
+
+        lods.resize(models.size());
+        meshed.resize(models.size());
+        instances.setModels(models);
+
+        impostor = std::make_unique<Impostor>(*meshes.front(), models.size());
+    }
+
+    void update(LodSelector& selector, float impostorDistance, float fadeDistance)
+    {
+        selector.select(levels, bounds, models, lods);
+
+        // Past the impostor distance, impostors fade in over the meshes, which
+        // are dropped once the fade is complete.
+        impostorModels.clear();
+        impostorFades.clear();
+        for (std::size_t i = 0; i < models.size(); ++i) {
+            const Vector4f center = models[i] * Vector4f{ bounds.getCenter(), 1 };
+            const float distance = length(Vector3f{ center.x, center.y, center.z }) - impostorDistance;
+            const float fade = fadeDistance > 0 ? std::clamp(distance / fadeDistance, 0.f, 1.f) : (distance >= 0 ? 1.f : 0.f);
+
+            if (fade > 0) {
+                impostorModels.push_back(models[i]);
+                impostorFades.push_back(fade);
+            }
+
+            meshed[i] = fade < 1;
+        }
+
+        impostor->setInstances(impostorModels, impostorFades);
+
+        // Group instances by level so that each level is a single draw.
+        counts.assign(levels.size(), 0);
+        for (std::size_t i = 0; i < models.size(); ++i)
+            if (meshed[i])
+                ++counts[lods[i]];
+
+        std::vector<int> offsets(levels.size(), 0);
+        for (std::size_t level = 1; level < levels.size(); ++level)
+            offsets[level] = offsets[level - 1] + counts[level - 1];
+
+        indices.resize(offsets.back() + counts.back());
+        for (std::size_t i = 0; i < models.size(); ++i)
+            if (meshed[i])
+                indices[offsets[lods[i]]++] = i;
 
+        instances.setIndices(indices);
+
+        // The pool takes the models directly, sorted by level.
+        sortedModels.clear();
+        for (unsigned int i : indices)
+            sortedModels.push_back(models[i]);
+
+        pool.clearDraws();
+
+        int first = 0;
+        for (std::size_t level = 0; level < levels.size(); ++level) {
+            pool.addDraw(poolMeshes[level], std::span{ sortedModels }.subspan(first, counts[level]));
+            first += counts[level];
+        }
+    }
+
+    // Instances are fanned out to viewCount views by the multi-view variants,
+    // the base instance still indexes the first of their own.
+    void draw(Shader& shader, int viewCount, Mesh::Stream stream = Mesh::Stream::All) const
+    {
+        instances.bind();
+        shader.bind();
+
+        int baseInstance = 0;
+        for (std::size_t level = 0; level < levels.size(); ++level) {
+            if (counts[level] > 0)
+                meshes[level]->drawInstanced(counts[level] * viewCount, baseInstance, stream);
+
+            baseInstance += counts[level];
+        }
+    }
+
+    // All levels in a single draw call, without any vertex array switch.
+    void drawPulled(Shader& shader, int viewCount) const
+    {
+        pool.draw(shader, viewCount);
+    }
+
+    void drawImpostors(Shader& shader, int viewCount) const
+    {
+        impostor->draw(shader, viewCount);
+    }
+};
+
+// Static pillars of small cubes along the sides and dynamic cubes orbiting the
+// rotating one, all candidates for batching.
+struct SmallObjects {
+    MeshBatcher batcher;
+    int cube;
+    std::vector<Matrix4f> pillars;
+    std::vector<Matrix4f> unbatchedPillars;
+    std::vector<Matrix4f> unbatched;
+    bool batching;
+    int maxVertexCount;
+
+    SmallObjects()
+        : batcher{ 1 << 16, 1 << 17 }
+        , batching{ false }
+        , maxVertexCount{ -1 }
+    {
+        cube = batcher.addMesh(CubeVertices, CubeIndices);
+
+        for (int side : { -1, 1 })
+            for (int k = 0; k < 12; ++k)
+                for (int j = 0; j < 8; ++j) {
+                    const Vector3f position{ 6.f * side, -3 + 0.5f * j, -6 - 2.f * k };
+                    pillars.push_back(Matrix4f::translate(position) * Matrix4f::scale(0.2f));
+                }
+    }
+
+    void update(const Vector3f& center, float time, bool batching, int maxVertexCount)
+    {
+        if (batching != this->batching || maxVertexCount != this->maxVertexCount) {
+            this->batching = batching;
+            this->maxVertexCount = maxVertexCount;
+            batcher.setMaxVertexCount(maxVertexCount);
+
+            batcher.clearStatic();
+            unbatchedPillars.clear();
+            for (const Matrix4f& model : pillars)
+                if (!batching || !batcher.addStatic(cube, model))
+                    unbatchedPillars.push_back(model);
+            batcher.buildStatic();
+        }
+
+        batcher.beginDynamic();
+        unbatched = unbatchedPillars;
+
+        for (int i = 0; i < 128; ++i) {
+            const float angle = 2 * std::numbers::pi_v<float> * i / 128 + (1 + i % 3) * time;
+            const float radius = 1.25f + 0.25f * (i % 3);
+            const Vector3f position = center + Vector3f{ radius * std::cos(angle), 0.5f * std::sin(3 * angle), radius * std::sin(angle) };
+            const Matrix4f model = Matrix4f::translate(position) * Matrix4f::scale(0.06f);
+
+            if (!batching || !batcher.addDynamic(cube, model))
+                unbatched.push_back(model);
+        }
+    }
+
+    void draw(Shader& shader, UniformRing& uniforms, const Mesh& mesh, int viewCount, Mesh::Stream stream = Mesh::Stream::All)
+    {
+        if (batching)
+            batcher.draw(shader, uniforms, viewCount);
+
+        shader.bind();
+        for (const Matrix4f& model : unbatched) {
+            uniforms.bindDraw(model);
+            mesh.drawInstanced(viewCount, 0, stream);
+        }
+    }
+};
+
+std::vector<Matrix4f> createField()
+{
+    std::vector<Matrix4f> models;
+    models.reserve(FieldSize * FieldSize);
+
+    for (int j = 0; j < FieldSize; ++j)
+        for (int i = 0; i < FieldSize; ++i) {
+            const Vector3f position{ 0.75f * (i - FieldSize / 2), 0.75f * (j - FieldSize / 2), -20 };
+            models.push_back(Matrix4f::translate(position) * Matrix4f::scale(0.25f));
+        }
+
+    return models;
+}
+
+// Expensive objects mostly hidden behind the rotating cube.
+std::vector<OcclusionQueries::Object> createLargeObjects(const Mesh& mesh)
+{
+    const Vector3f positions[] = {
+        { 0, 0, -9 },
+        { 0, 0, -13 },
+        { 0.5f, 0.25f, -17 },
+        { 3, 1.5f, -12 },
+        { -3, 1.5f, -12 }
+    };
+
+    std::vector<OcclusionQueries::Object> objects;
+    for (const Vector3f& position : positions)
+        objects.push_back({ .mesh = &mesh, .model = Matrix4f::translate(position) * Matrix4f::scale(0.8f) });
+
+    return objects;
+}
+
+// Views on a grid around the shared eye, turned away from each other by a
+// fixed angle.
+std::vector<Matrix4f> createViewRotations(int count)
+{
+    const Vector2i grid = MultiView::getGridSize(count);
+    const float step = degToRad(15.f);
+
+    std::vector<Matrix4f> rotations;
+    for (int i = 0; i < count; ++i) {
+        const float yaw = step * (0.5f * (grid.x - 1) - i % grid.x);
+        const float pitch = step * (0.5f * (grid.y - 1) - i / grid.x);
+        rotations.push_back(Matrix4f::rotateY(yaw) * Matrix4f::rotateX(pitch));
+    }
+
+    return rotations;
+}
+
+std::vector<ClusteredLighting::PointLight> createLights(int count, float time)
+{
+    std::mt19937 generator{ 42 };
+    std::uniform_real_distribution<float> unit{ 0, 1 };
+
+    std::vector<ClusteredLighting::PointLight> lights;
+    lights.reserve(count);
+
+    const float extent = 0.75f * FieldSize / 2;
+    for (int i = 0; i < count; ++i) {
+        const float radius = extent * std::sqrt(unit(generator));
+        const float phase = 2 * std::numbers::pi_v<float> * unit(generator);
+        const float speed = 0.25f + unit(generator);
+        const float angle = phase + speed * time;
+
+        lights.push_back(ClusteredLighting::PointLight{
+            .position = Vector3f{ radius * std::cos(angle), radius * std::sin(angle), -19 },
+            .radius = 4,
+            .color = Vector3f{ unit(generator), unit(generator), unit(generator) },
+            .intensity = 8 });
+    }
+
+    return lights;
+}
+
+// Shared by every window. Scene programs are indices into the library, their
+// variant is picked every frame.
+struct Scene {
+    ShaderLibrary& library;
+    int mainProgram;
+    int instancedProgram;
+    int depthProgram;
+    int instancedDepthProgram;
+    int pullingProgram;
+    int pullingDepthProgram;
+    int impostorProgram;
+    const Mesh& mesh;
+    const std::vector<Matrix4f>& field;
+    OcclusionRasterizer& rasterizer;
+    const std::vector<OcclusionQueries::Object>& largeObjects;
+    ClusteredLighting& lighting;
+    Spheres& spheres;
+    SmallObjects& smallObjects;
+    LodSelector& lodSelector;
+    DebugDraw& debugDraw;
+    ThreadPool& threadPool;
+    PostProcessing& postProcessing;
+    DynamicResolution& resolution;
+    MultiView& multiView;
+    UniformRing& uniforms;
+};
+
+// A window with its own render targets, and the state carried from one of its
+// frames to the next: occlusion culling works from the visibility and the
+// depth of the previous frame of the same window, and a query only guards
+// draws of the window it was issued in.
+struct Surface {
+    Window window;
+    Framebuffer framebuffer;
+    Framebuffer output;
+    OcclusionCuller culler;
+    OcclusionQueries queries;
+    RenderGraph graph;
+    GpuTimer depthTimer;
+    GpuTimer colorTimer;
+
+    // Scene color is HDR, post-processing brings it to display range.
+    Surface(Platform& platform, const std::string& title, const Vector2i& size, bool primary, int largeObjectCount)
+        : window{ platform, title, size, primary }
+        , framebuffer{ size, GL_RGBA16F }
+        , output{ size }
+        , culler{ FieldSize * FieldSize }
+        , queries{ largeObjectCount }
+    {
+    }
+
+    explicit operator bool() const { return window && culler && queries; }
+};
+
+// Settings and animation of a frame, shared by every window.
+struct Frame {
+    float fovY;
+    float zNear;
+    float zFar;
+    int viewCount;
+    bool faceBorders;
+    float time;
+    Matrix4f model;
+    std::vector<ClusteredLighting::PointLight> lights;
+    bool vertexPulling;
+    bool depthPrepass;
+    bool occlusionQueries;
+    int requeryInterval;
+    bool debug;
+    bool postProcess;
+    PostProcessing::Settings postSettings;
+    float upscaleSharpness;
+};
+
+enum class Culling {
+    None,
+    HiZ,
+    Software
+};
+
+void prepareField(const Matrix4f& projection, const Matrix4f& occluderModel, OcclusionCuller& culler, bool overlay, Scene& scene)
+{
+    static int culling = static_cast<int>(Culling::HiZ);
+    const char* const cullingNames[] = { "None", "Hi-Z (GPU)", "Software (CPU)" };
+    if (overlay)
+        ImGui::Combo("Occlusion culling", &culling, cullingNames, std::size(cullingNames));
+
+    if (culling == static_cast<int>(Culling::Software)) {
+        // Occluded instances are dropped here and never reach the driver.
+        scene.rasterizer.begin(projection);
+        scene.rasterizer.addOccluder(CubeVertices, CubeIndices, occluderModel);
+        scene.rasterizer.rasterize();
+
+        static std::vector<std::uint8_t> visible;
+        visible.resize(scene.field.size());
+        scene.rasterizer.testVisibility(scene.mesh.getBounds(), scene.field, visible);
+
+        static std::vector<Matrix4f> models;
+        models.clear();
+        for (std::size_t i = 0; i < scene.field.size(); ++i)
+            if (visible[i])
+                models.push_back(scene.field[i]);
+
+        culler.setInstances(models, scene.mesh.getBounds());
+
+        if (overlay)
+            ImGui::Text("Software culled: %d", static_cast<int>(scene.field.size() - models.size()));
+    } else {
+        culler.setInstances(scene.field, scene.mesh.getBounds());
+    }
+
+    culler.setOcclusionCulling(culling == static_cast<int>(Culling::HiZ));
+}
+
+void updateLods(float fovY, const Vector2i& size, bool overlay, Scene& scene)
+{
+    static float threshold = 1;
+    static float hysteresis = 0.25f;
+    static bool triangleBudget = false;
+    static float bias = 0;
+    static int budget = 50000;
+    static float fadeStart = 24;
+    static float fadeEnd = 28;
+
+    if (overlay) {
+        ImGui::SliderFloat("LOD threshold (px)", &threshold, 0.25f, 8);
+        ImGui::SliderFloat("LOD hysteresis", &hysteresis, 0, 0.9f);
+        ImGui::Checkbox("LOD triangle budget", &triangleBudget);
+        if (triangleBudget)
+            ImGui::SliderInt("Budget", &budget, 1000, 500000);
+        else
+            ImGui::SliderFloat("LOD bias", &bias, -4, 8);
+        ImGui::DragFloatRange2("Impostor fade start <-> end", &fadeStart, &fadeEnd, 0.25f, 0, 100);
+    }
+
+    LodSelector& selector = scene.lodSelector;
+    selector.setProjection(fovY, size.y);
+    selector.setThreshold(threshold);
+    selector.setHysteresis(hysteresis);
+    selector.setTriangleBudget(triangleBudget ? budget : 0);
+    if (!triangleBudget)
+        selector.setBias(bias);
+
+    selector.beginFrame();
+    scene.spheres.update(selector, fadeStart, fadeEnd - fadeStart);
+    selector.endFrame();
+
+    if (overlay) {
+        ImGui::Text("LOD triangles: %d (bias %.2f)", selector.getTriangleCount(), selector.getBias());
+        ImGui::Text("Impostors: %d", scene.spheres.impostor->getInstanceCount());
+    }
+}
+
+// Emits the debug geometry of the frame, flushed by the debug pass.
+bool emitDebug(const Matrix4f& occluderModel, std::span<const ClusteredLighting::PointLight> lights, bool overlay, Scene& scene)
+{
+    static bool enabled = false;
+    if (overlay)
+        ImGui::Checkbox("Debug draw", &enabled);
+    if (!enabled)
+        return false;
+
+    DebugDraw& debugDraw = scene.debugDraw;
+    debugDraw.begin();
+
+    debugDraw.box(scene.mesh.getBounds(), occluderModel, Vector3f{ 1, 1, 0 });
+
+    // Sphere bounds are emitted from the worker threads, colored by level.
+    const Spheres& spheres = scene.spheres;
+    scene.threadPool.parallelFor(spheres.models.size(), [&](int i) {
+        const float t = spheres.lods[i] / static_cast<float>(spheres.levels.size() - 1);
+        debugDraw.box(spheres.bounds, spheres.models[i], Vector3f{ t, 1 - t, 0 });
+    });
+
+    for (const ClusteredLighting::PointLight& light : lights) {
+        debugDraw.sphere(light.position, light.radius, light.color);
+        debugDraw.arrow(light.position + Vector3f{ 0, 0, 1 }, light.position, light.color);
+    }
+
+    if (overlay && debugDraw.getDroppedVertexCount() > 0)
+        ImGui::Text("Debug vertices dropped: %d", debugDraw.getDroppedVertexCount());
+
+    return true;
+}
+
+void showStatistics(bool depthPrepass, const Surface& surface, const Scene& scene)
+{
+    if (depthPrepass)
+        ImGui::Text("Depth pass: %.3f ms", surface.depthTimer.getMilliseconds());
+
+    ImGui::Text("Color pass: %.3f ms", surface.colorTimer.getMilliseconds());
+
+    const OcclusionCuller::Statistics& statistics = surface.culler.getStatistics();
+    ImGui::Text("Instances: %d (early %d, late %d)", statistics.instanceCount, statistics.earlyDrawCount, statistics.lateDrawCount);
+    ImGui::Text("Culled: %d frustum, %d occlusion", statistics.frustumCulledCount, statistics.occlusionCulledCount);
+
+    const MeshBatcher::Statistics& batchStatistics = scene.smallObjects.batcher.getStatistics();
+    const int smallDrawCount = batchStatistics.drawCount + static_cast<int>(scene.smallObjects.unbatched.size());
+    ImGui::Text("Small objects: %d draws (%d saved, %d refused)", smallDrawCount, batchStatistics.savedDrawCount, batchStatistics.refusedObjectCount);
+
+    const OcclusionQueries::Statistics& queryStatistics = surface.queries.getStatistics();
+    ImGui::Text("Large objects: %d (%d queries, %d conditional)", queryStatistics.objectCount, queryStatistics.queryCount, queryStatistics.conditionalDrawCount);
+    ImGui::Text("Skipped: %d draws, %d triangles", queryStatistics.skippedDrawCount, queryStatistics.skippedTriangleCount);
+
+    const DeletionQueue::Statistics deletionStatistics = DeletionQueue::getStatistics();
+    ImGui::Text("Deletions: %d deleted, %d pending, %.3f ms", deletionStatistics.deletedCount, deletionStatistics.pendingCount, deletionStatistics.milliseconds);
+    ImGui::Text("Uniform ring: grown %d times", scene.uniforms.getStatistics().growCount);
+
+    const RenderGraph& graph = surface.graph;
+    const RenderGraph::Statistics& graphStatistics = graph.getStatistics();
+    ImGui::Text("Render graph: %d passes (%d culled), %d barriers", graphStatistics.passCount, graphStatistics.culledPassCount, graphStatistics.barrierCount);
+    ImGui::Text("Transients: %d in %d targets, %.2f / %.2f MiB", graphStatistics.transientCount, graphStatistics.physicalCount, graphStatistics.physicalBytes / 1048576.0, graphStatistics.transientBytes / 1048576.0);
+
+    for (const RenderGraph::PassTiming& timing : graph.getTimings())
+        ImGui::Text("  %s: %.3f ms GPU, %.3f ms CPU", timing.name.c_str(), timing.milliseconds, timing.cpuMilliseconds);
+}
+
+// Advances the animation and reads the overlay settings. Levels of detail,
+// small objects and debug geometry are prepared once for every window, from
+// the render size of the primary one.
+Frame update(const Vector2i& renderSize, bool overlay, Scene& scene)
+{
+    static float fovY = 50;
     static float zNear = 0.125f;
     static float zFar = 64;
-    ImGui::DragFloatRange2("zNear <-> zFar", &zNear, &zFar, 0.125f, 0.01f, 100);
+    static int lightCount = 256;
+    static float degPerSecond = 90;
 
-    const float aspect = size.x / static_cast<float>(size.y);
-    shader.setUniform("projection", Matrix4f::perspective(degToRad(fovY), aspect, zNear, zFar));
+    if (overlay) {
+        ImGui::SliderFloat("fovY", &fovY, 5, 175);
+        ImGui::DragFloatRange2("zNear <-> zFar", &zNear, &zFar, 0.125f, 0.01f, 100);
+        ImGui::SliderInt("Lights", &lightCount, 0, MaxLightCount);
+        ImGui::SliderFloat("degPerSecond", &degPerSecond, 0, 360);
+    }
+
+    static int viewCount = 1;
+    if (overlay && scene.multiView)
+        ImGui::SliderInt("Views", &viewCount, 1, MultiView::MaxViewCount);
+
+    static bool faceBorders = true;
+    if (overlay)
+        ImGui::Checkbox("Face borders", &faceBorders);
+
+    static float time = 0;
+    time += 1.f / 30;
 
-    static float degPerSecond = 90;
-    ImGui::SliderFloat("degPerSecond", &degPerSecond, 0, 360);
     static float angle = 0;
     angle += degToRad(degPerSecond) * (1.f / 30);
 
     const Vector3f position{ 0, 0, -5 };
     const Vector3f axis{ 1, 2, 1 };
-    shader.setUniform("model", Matrix4f::translate(position) * Matrix4f::rotate(axis, angle));
+    const Matrix4f model = Matrix4f::translate(position) * Matrix4f::rotate(axis, angle);
+
+    std::vector<ClusteredLighting::PointLight> lights = createLights(lightCount, time);
+
+    updateLods(degToRad(fovY), renderSize, overlay, scene);
+
+    static bool vertexPulling = false;
+    static bool depthPrepass = false;
+    static bool batching = true;
+    static int maxBatchVertexCount = 256;
+    static bool occlusionQueries = true;
+    static int requeryInterval = 8;
+
+    if (overlay) {
+        ImGui::Checkbox("Vertex pulling", &vertexPulling);
+        ImGui::Checkbox("Depth pre-pass", &depthPrepass);
+        ImGui::Checkbox("Batching", &batching);
+        ImGui::SliderInt("Batch max vertices", &maxBatchVertexCount, 0, 1024);
+        ImGui::Checkbox("Occlusion queries", &occlusionQueries);
+        ImGui::SliderInt("Requery interval", &requeryInterval, 1, 60);
+    }
+
+    scene.smallObjects.update(position, time, batching, maxBatchVertexCount);
+
+    const bool debug = emitDebug(model, lights, overlay, scene);
+
+    static bool postProcess = true;
+    if (overlay)
+        ImGui::Checkbox("Post-processing", &postProcess);
+
+    static PostProcessing::Settings postSettings;
+    if (overlay && postProcess) {
+        ImGui::SliderFloat("Exposure", &postSettings.exposure, 0.125f, 8, "%.3f", ImGuiSliderFlags_Logarithmic);
+        ImGui::SliderFloat("Contrast", &postSettings.contrast, 0.5f, 1.5f);
+        ImGui::SliderFloat("Saturation", &postSettings.saturation, 0, 2);
+        ImGui::ColorEdit3("Tint", &postSettings.tint.x);
+        ImGui::SliderFloat("Vignette", &postSettings.vignette, 0, 1);
+        ImGui::SliderFloat("Sharpness", &postSettings.sharpness, 0, 1);
+    }
 
-    shader.bind();
-    mesh.draw();
+    static bool dynamicResolution = false;
+    static float gpuBudget = 12;
+    static float minRenderScale = 0.5f;
+    static float upscaleSharpness = 0.25f;
+
+    if (overlay) {
+        ImGui::Checkbox("Dynamic resolution", &dynamicResolution);
+        if (dynamicResolution) {
+            ImGui::SliderFloat("GPU budget (ms)", &gpuBudget, 1, 33);
+            ImGui::SliderFloat("Min render scale", &minRenderScale, 0.25f, 1);
+        }
+        ImGui::SliderFloat("Upscale sharpness", &upscaleSharpness, 0, 1);
+        ImGui::Text("Render: %dx%d (%.0f%%), GPU %.3f ms", renderSize.x, renderSize.y, 100 * scene.resolution.getScale(), scene.resolution.getMilliseconds());
+    }
+
+    scene.resolution.setEnabled(dynamicResolution);
+    scene.resolution.setBudget(gpuBudget);
+    scene.resolution.setMinScale(minRenderScale);
+
+    return Frame{
+        .fovY = fovY,
+        .zNear = zNear,
+        .zFar = zFar,
+        .viewCount = viewCount,
+        .faceBorders = faceBorders,
+        .time = time,
+        .model = model,
+        .lights = std::move(lights),
+        .vertexPulling = vertexPulling,
+        .depthPrepass = depthPrepass,
+        .occlusionQueries = occlusionQueries,
+        .requeryInterval = requeryInterval,
+        .debug = debug,
+        .postProcess = postProcess,
+        .postSettings = postSettings,
+        .upscaleSharpness = upscaleSharpness
+    };
 }
 
-int main()
+// Renders the frame at the framebuffer size of the surface and presents it
+// upscaled to its output. Must be called between UniformRing::begin() and
+// end().
+void render(const Frame& frame, Surface& surface, bool overlay, Scene& scene)
 {
-    Window window{ "Cube", Vector2i{ 1280, 720 } };
-    if (!window)
-        return EXIT_FAILURE;
+    const Framebuffer& framebuffer = surface.framebuffer;
+    const Framebuffer& output = surface.output;
+    const Vector2i& renderSize = framebuffer.getSize();
+    const Vector2i& size = output.getSize();
 
-    Shader shader = Shader::loadFromFile("shaders/main.vs.glsl", "shaders/main.fs.glsl");
-    if (!shader)
-        return EXIT_FAILURE;
+    const Matrix4f& model = frame.model;
+    const bool depthPrepass = frame.depthPrepass;
+    const bool vertexPulling = frame.vertexPulling;
+
+    // With several views, culling and light binning run once against the
+    // frustum enclosing them all, and every draw is fanned out to the views by
+    // the multi-view variants.
+    const bool multiView = frame.viewCount > 1 && scene.multiView;
+    const int drawViewCount = multiView ? frame.viewCount : 1;
 
-    const Mesh::Vertex vertices[] = {
-        // Front
-        { .position = Vector3f{ -1, -1, 1 }, .color = Vector3f{ 1, 0, 0 }, .texCoords = Vector2f{ 0, 0 } },
-        { .position = Vector3f{ 1, -1, 1 }, .color = Vector3f{ 1, 0, 0 }, .texCoords = Vector2f{ 1, 0 } },
-        { .position = Vector3f{ 1, 1, 1 }, .color = Vector3f{ 1, 0, 0 }, .texCoords = Vector2f{ 1, 1 } },
-        { .position = Vector3f{ -1, 1, 1 }, .color = Vector3f{ 1, 0, 0 }, .texCoords = Vector2f{ 0, 1 } },
-        // Right
-        { .position = Vector3f{ 1, -1, 1 }, .color = Vector3f{ 0, 1, 0 }, .texCoords = Vector2f{ 0, 0 } },
-        { .position = Vector3f{ 1, -1, -1 }, .color = Vector3f{ 0, 1, 0 }, .texCoords = Vector2f{ 1, 0 } },
-        { .position = Vector3f{ 1, 1, -1 }, .color = Vector3f{ 0, 1, 0 }, .texCoords = Vector2f{ 1, 1 } },
-        { .position = Vector3f{ 1, 1, 1 }, .color = Vector3f{ 0, 1, 0 }, .texCoords = Vector2f{ 0, 1 } },
-        // Back
-        { .position = Vector3f{ 1, -1, -1 }, .color = Vector3f{ 0, 0, 1 }, .texCoords = Vector2f{ 0, 0 } },
-        { .position = Vector3f{ -1, -1, -1 }, .color = Vector3f{ 0, 0, 1 }, .texCoords = Vector2f{ 1, 0 } },
-        { .position = Vector3f{ -1, 1, -1 }, .color = Vector3f{ 0, 0, 1 }, .texCoords = Vector2f{ 1, 1 } },
-        { .position = Vector3f{ 1, 1, -1 }, .color = Vector3f{ 0, 0, 1 }, .texCoords = Vector2f{ 0, 1 } },
-        // Left
-        { .position = Vector3f{ -1, -1, -1 }, .color = Vector3f{ 0, 1, 1 }, .texCoords = Vector2f{ 0, 0 } },
-        { .position = Vector3f{ -1, -1, 1 }, .color = Vector3f{ 0, 1, 1 }, .texCoords = Vector2f{ 1, 0 } },
-        { .position = Vector3f{ -1, 1, 1 }, .color = Vector3f{ 0, 1, 1 }, .texCoords = Vector2f{ 1, 1 } },
-        { .position = Vector3f{ -1, 1, -1 }, .color = Vector3f{ 0, 1, 1 }, .texCoords = Vector2f{ 0, 1 } },
-        // Top
-        { .position = Vector3f{ -1, 1, 1 }, .color = Vector3f{ 1, 1, 0 }, .texCoords = Vector2f{ 0, 0 } },
-        { .position = Vector3f{ 1, 1, 1 }, .color = Vector3f{ 1, 1, 0 }, .texCoords = Vector2f{ 1, 0 } },
-        { .position = Vector3f{ 1, 1, -1 }, .color = Vector3f{ 1, 1, 0 }, .texCoords = Vector2f{ 1, 1 } },
-        { .position = Vector3f{ -1, 1, -1 }, .color = Vector3f{ 1, 1, 0 }, .texCoords = Vector2f{ 0, 1 } },
-        // Bottom
-        { .position = Vector3f{ -1, -1, -1 }, .color = Vector3f{ 1, 0, 1 }, .texCoords = Vector2f{ 0, 0 } },
-        { .position = Vector3f{ 1, -1, -1 }, .color = Vector3f{ 1, 0, 1 }, .texCoords = Vector2f{ 1, 0 } },
-        { .position = Vector3f{ 1, -1, 1 }, .color = Vector3f{ 1, 0, 1 }, .texCoords = Vector2f{ 1, 1 } },
-        { .position = Vector3f{ -1, -1, 1 }, .color = Vector3f{ 1, 0, 1 }, .texCoords = Vector2f{ 0, 1 } }
+    // A variant used for the first time compiles in parallel, its objects are
+    // skipped until it is ready. Face borders only concern the color programs.
+    const std::uint32_t viewFeatures = multiView ? MultipleViews : 0;
+    const std::uint32_t features = (frame.faceBorders ? FaceBorders : 0) | viewFeatures;
+    Shader& shader = scene.library.getVariant(scene.mainProgram, features);
+    Shader& instancedShader = scene.library.getVariant(scene.instancedProgram, features);
+    Shader& depthShader = scene.library.getVariant(scene.depthProgram, viewFeatures);
+    Shader& instancedDepthShader = scene.library.getVariant(scene.instancedDepthProgram, viewFeatures);
+    Shader& pullingShader = scene.library.getVariant(scene.pullingProgram, features);
+    Shader& pullingDepthShader = scene.library.getVariant(scene.pullingDepthProgram, viewFeatures);
+    Shader& impostorShader = scene.library.getVariant(scene.impostorProgram, viewFeatures);
+
+    // Sampled before any uniform is set, so that no program becomes ready
+    // halfway through the frame without the uniforms set before.
+    const struct {
+        bool main;
+        bool instanced;
+        bool depth;
+        bool instancedDepth;
+        bool pulling;
+        bool pullingDepth;
+        bool impostor;
+    } ready{
+        .main = shader.isReady(),
+        .instanced = instancedShader.isReady(),
+        .depth = depthShader.isReady(),
+        .instancedDepth = instancedDepthShader.isReady(),
+        .pulling = pullingShader.isReady(),
+        .pullingDepth = pullingDepthShader.isReady(),
+        .impostor = impostorShader.isReady()
     };
+    MultiView::Frustum frustum{ degToRad(frame.fovY), size.x / static_cast<float>(size.y), frame.zNear, frame.zFar };
+    if (multiView) {
+        scene.multiView.setViews(createViewRotations(frame.viewCount), frustum.fovY, frame.zNear, frame.zFar, renderSize);
+        frustum = scene.multiView.getFrustum();
+    }
+
+    const Matrix4f projection = Matrix4f::perspective(frustum.fovY, frustum.aspect, frustum.zNear, frustum.zFar);
+    const std::span<const Matrix4f> viewProjections = multiView ? scene.multiView.getViewProjections() : std::span<const Matrix4f>{ &projection, 1 };
+
+    scene.uniforms.bindFrame(projection, frame.time);
+
+    scene.lighting.update(frame.lights, frustum.fovY, frustum.aspect, frustum.zNear, frustum.zFar);
+    scene.lighting.apply(shader);
+    scene.lighting.apply(instancedShader);
+    scene.lighting.apply(pullingShader);
+    scene.lighting.apply(impostorShader);
+
+    // Views share the eye, so software occlusion from the enclosing frustum
+    // holds for all of them. The Hi-Z pyramid cannot be built from several
+    // viewports.
+    OcclusionCuller& culler = surface.culler;
+    prepareField(projection, model, culler, overlay, scene);
+    culler.setViewCount(drawViewCount);
+    if (multiView)
+        culler.setOcclusionCulling(false);
+
+    OcclusionQueries& queries = surface.queries;
+    queries.setEnabled(frame.occlusionQueries);
+    queries.setRequeryInterval(frame.requeryInterval);
+
+    // Objects are skipped until every program they need this frame is ready,
+    // so that the depth pre-pass and the color passes agree.
+    const bool cubeReady = ready.main && (!depthPrepass || ready.depth);
+    const bool fieldReady = ready.instanced && (!depthPrepass || ready.instancedDepth);
+    const bool spheresReady = vertexPulling
+        ? ready.pulling && (!depthPrepass || ready.pullingDepth)
+        : ready.instanced && (!depthPrepass || ready.instancedDepth);
+    const bool impostorsReady = ready.impostor;
+    const bool largeObjectsReady = ready.main;
 
-    const unsigned int indices[] = {
-        // Front
-        0, 1, 2, 2, 3, 0,
-        // Right
-        4, 5, 6, 6, 7, 4,
-        // Back
-        8, 9, 10, 10, 11, 8,
-        // Left
-        12, 13, 14, 14, 15, 12,
-        // Top
-        16, 17, 18, 18, 19, 16,
-        // Bottom
-        20, 21, 22, 22, 23, 20
+    using Access = RenderGraph::Access;
+
+    RenderGraph& graph = surface.graph;
+    graph.reset();
+
+    const RenderGraph::Resource color = graph.importTexture("Color", framebuffer.getColorTexture());
+    const RenderGraph::Resource depth = graph.importTexture("Depth", framebuffer.getDepthTexture());
+    const RenderGraph::Resource backbuffer = graph.importTexture("Output", output.getColorTexture());
+    graph.markOutput(backbuffer);
+
+    graph.addPass(
+        "Clear",
+        [&](RenderGraph::PassBuilder& builder) {
+            builder.write(color, Access::Transfer);
+            builder.write(depth, Access::Transfer);
+        },
+        [](const RenderGraph&) {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        });
+
+    // Scene passes draw into every view at once.
+    const auto bindViews = [&] {
+        if (multiView)
+            scene.multiView.bind();
     };
+    const auto unbindViews = [&] {
+        if (multiView)
+            scene.multiView.unbind(renderSize);
+    };
+
+    if (depthPrepass)
+        graph.addPass(
+            "Depth pre-pass",
+            [&](RenderGraph::PassBuilder& builder) {
+                builder.write(depth, Access::Attachment);
+            },
+            [&](const RenderGraph&) {
+                surface.depthTimer.begin();
+                bindViews();
+
+                if (cubeReady) {
+                    scene.uniforms.bindDraw(model);
+                    depthShader.bind();
+                    scene.mesh.drawInstanced(drawViewCount, 0, Mesh::Stream::Position);
+                    scene.smallObjects.draw(depthShader, scene.uniforms, scene.mesh, drawViewCount, Mesh::Stream::Position);
+                }
+                if (spheresReady) {
+                    if (vertexPulling)
+                        scene.spheres.drawPulled(pullingDepthShader, drawViewCount);
+                    else
+                        scene.spheres.draw(instancedDepthShader, drawViewCount, Mesh::Stream::Position);
+                }
+                if (fieldReady)
+                    culler.render(projection, framebuffer, instancedDepthShader, scene.mesh, Mesh::Stream::Position);
+
+                unbindViews();
+                surface.depthTimer.end();
+            });
+
+    // The color timer spans the opaque pass up to the large objects, which all
+    // write color and therefore keep their order.
+    graph.addPass(
+        "Opaque",
+        [&](RenderGraph::PassBuilder& builder) {
+            builder.write(color, Access::Attachment);
+            builder.write(depth, Access::Attachment);
+        },
+        [&](const RenderGraph&) {
+            surface.colorTimer.begin();
+            bindViews();
+
+            // Depth is final, only the visible fragment of each pixel is shaded.
+            if (depthPrepass) {
+                glDepthFunc(GL_EQUAL);
+                glDepthMask(GL_FALSE);
+            }
+
+            if (cubeReady) {
+                scene.uniforms.bindDraw(model);
+                shader.bind();
+                scene.mesh.drawInstanced(drawViewCount, 0);
+                scene.smallObjects.draw(shader, scene.uniforms, scene.mesh, drawViewCount);
+            }
+
+            if (spheresReady) {
+                if (vertexPulling)
+                    scene.spheres.drawPulled(pullingShader, drawViewCount);
+                else
+                    scene.spheres.draw(instancedShader, drawViewCount);
+            }
+
+            if (fieldReady) {
+                if (depthPrepass)
+                    culler.redraw(instancedShader, scene.mesh);
+                else
+                    culler.render(projection, framebuffer, instancedShader, scene.mesh);
+            }
+
+            if (depthPrepass) {
+                glDepthFunc(GL_LESS);
+                glDepthMask(GL_TRUE);
+            }
+
+            unbindViews();
+        });
+
+    // Impostors discard fragments, they are left out of the depth pre-pass.
+    graph.addPass(
+        "Impostors",
+        [&](RenderGraph::PassBuilder& builder) {
+            builder.write(color, Access::Attachment);
+            builder.write(depth, Access::Attachment);
+        },
+        [&](const RenderGraph&) {
+            bindViews();
+            if (impostorsReady)
+                scene.spheres.drawImpostors(impostorShader, drawViewCount);
+            unbindViews();
+        });
+
+    // Tested against everything drawn so far.
+    graph.addPass(
+        "Large objects",
+        [&](RenderGraph::PassBuilder& builder) {
+            builder.write(color, Access::Attachment);
+            builder.write(depth, Access::Attachment);
+        },
+        [&](const RenderGraph&) {
+            bindViews();
+            if (largeObjectsReady)
+                queries.render(viewProjections, scene.largeObjects, shader, scene.uniforms);
+            unbindViews();
+
+            surface.colorTimer.end();
+        });
+
+    if (frame.debug)
+        graph.addPass(
+            "Debug",
+            [&](RenderGraph::PassBuilder& builder) {
+                builder.write(color, Access::Attachment);
+                builder.write(depth, Access::Attachment);
+            },
+            [&](const RenderGraph&) {
+                bindViews();
+                scene.debugDraw.flush(projection, drawViewCount);
+                unbindViews();
+            });
+
+    // Culled by the graph when its output is not presented.
+    const RenderGraph::Resource display = graph.createTexture("Display", { .size = renderSize, .format = GL_RGBA8 });
+    graph.addPass(
+        "Post-processing",
+        [&](RenderGraph::PassBuilder& builder) {
+            builder.read(color, Access::Sampled);
+            builder.write(display, Access::Image);
+        },
+        [&](const RenderGraph& graph) {
+            scene.postProcessing.apply(framebuffer.getColorTexture(), graph.getTexture(display), renderSize, frame.postSettings);
+        });
+
+    graph.addPass(
+        "Present",
+        [&](RenderGraph::PassBuilder& builder) {
+            builder.read(frame.postProcess ? display : color, Access::Sampled);
+            builder.write(backbuffer, Access::Attachment);
+        },
+        [&](const RenderGraph& graph) {
+            // Sharpening only makes up for upscaling.
+            const GLuint texture = frame.postProcess ? graph.getTexture(display) : framebuffer.getColorTexture();
+            scene.postProcessing.present(texture, output, renderSize == size ? 0 : frame.upscaleSharpness);
+        });
+
+    graph.compile();
+    graph.execute();
+
+    if (overlay)
+        showStatistics(depthPrepass, surface, scene);
+}
+
+// Renders the cube and the field on the CPU, without a window or a GL
+// context, and writes the last frame to software.ppm.
+int renderHeadless()
+{
+    ThreadPool threadPool;
+    SoftwareRenderer renderer{ threadPool, Vector2i{ 1280, 720 } };
+
+    const Vector2i& size = renderer.getSize();
+    const Matrix4f projection = Matrix4f::perspective(degToRad(50.f), size.x / static_cast<float>(size.y), 0.125f, 64);
+    const std::vector<Matrix4f> field = createField();
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int frame = 1; frame <= HeadlessFrameCount; ++frame) {
+        const float time = frame / 30.f;
+        const std::vector<ClusteredLighting::PointLight> lights = createLights(256, time);
+
+        renderer.begin(projection, lights, 0.2f);
+
+        const Matrix4f model = Matrix4f::translate(Vector3f{ 0, 0, -5 }) * Matrix4f::rotate(Vector3f{ 1, 2, 1 }, degToRad(90.f) * time);
+        renderer.draw(CubeVertices, CubeIndices, model);
+
+        for (const Matrix4f& fieldModel : field)
+            renderer.draw(CubeVertices, CubeIndices, fieldModel);
 
-    const Mesh mesh{ vertices, indices };
+        renderer.rasterize();
+    }
+
+    const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    const SoftwareRenderer::Statistics& statistics = renderer.getStatistics();
+    spdlog::info("Software rendering at {}x{} on {} threads: {:.2f} ms per frame, {} triangles binned {} times",
+        size.x, size.y, threadPool.getThreadCount(), elapsed.count() / HeadlessFrameCount,
+        statistics.triangleCount, statistics.binnedTriangleCount);
+
+    // Binary PPM, rows top to bottom.
+    std::ofstream file{ "software.ppm", std::ios::binary };
+    file << "P6\n"
+         << size.x << ' ' << size.y << "\n255\n";
+
+    const std::span<const std::uint32_t> image = renderer.getColor();
+    for (int y = size.y - 1; y >= 0; --y)
+        for (int x = 0; x < size.x; ++x) {
+            const std::uint32_t pixel = image[y * size.x + x];
+            const char rgb[] = { static_cast<char>(pixel & 0xff), static_cast<char>(pixel >> 8 & 0xff), static_cast<char>(pixel >> 16 & 0xff) };
+            file.write(rgb, sizeof(rgb));
+        }
+
+    if (!file) {
+        spdlog::error("Failed to write software.ppm");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && std::string_view{ argv[1] } == "--software")
+        return renderHeadless();
+
+    Platform platform;
+    if (!platform)
+        return EXIT_FAILURE;
+
+    // Programs with features only pre-warm their default variant, the others
+    // compile when first used.
+    ShaderLibrary library;
+
+    const int mainProgram = library.loadVariants("shaders/main.vs.glsl", "shaders/main.fs.glsl", SceneKeywords, Shader::Compilation::Parallel);
+    if (!library.getVariant(mainProgram, FaceBorders))
+        return EXIT_FAILURE;
+
+    const int instancedProgram = library.loadVariants("shaders/instanced.vs.glsl", "shaders/main.fs.glsl", SceneKeywords, Shader::Compilation::Parallel);
+    if (!library.getVariant(instancedProgram, FaceBorders))
+        return EXIT_FAILURE;
+
+    const int depthProgram = library.loadVariants("shaders/depth.vs.glsl", "shaders/depth.fs.glsl", SceneKeywords, Shader::Compilation::Parallel);
+    if (!library.getVariant(depthProgram, 0))
+        return EXIT_FAILURE;
+
+    const int instancedDepthProgram = library.loadVariants("shaders/instanceddepth.vs.glsl", "shaders/depth.fs.glsl", SceneKeywords, Shader::Compilation::Parallel);
+    if (!library.getVariant(instancedDepthProgram, 0))
+        return EXIT_FAILURE;
+
+    const int pullingProgram = library.loadVariants("shaders/pulling.vs.glsl", "shaders/main.fs.glsl", SceneKeywords, Shader::Compilation::Parallel);
+    if (!library.getVariant(pullingProgram, FaceBorders))
+        return EXIT_FAILURE;
+
+    const int pullingDepthProgram = library.loadVariants("shaders/pulling.vs.glsl", "shaders/depth.fs.glsl", SceneKeywords, Shader::Compilation::Parallel);
+    if (!library.getVariant(pullingDepthProgram, 0))
+        return EXIT_FAILURE;
+
+    const int impostorProgram = library.loadVariants("shaders/impostor.vs.glsl", "shaders/impostor.fs.glsl", SceneKeywords, Shader::Compilation::Parallel);
+    if (!library.getVariant(impostorProgram, 0))
+        return EXIT_FAILURE;
+
+    const Mesh mesh{ CubeVertices, CubeIndices };
+
+    const std::vector<Matrix4f> field = createField();
+
+    const MeshData largeSphereData = createCubeSphere(LargeSphereSubdivisions);
+    const Mesh largeSphere{ largeSphereData.vertices, largeSphereData.indices };
+    const std::vector<OcclusionQueries::Object> largeObjects = createLargeObjects(largeSphere);
+
+    // The primary window comes first and also shows the overlay.
+    const int largeObjectCount = static_cast<int>(largeObjects.size());
+    std::vector<std::unique_ptr<Surface>> surfaces;
+    surfaces.push_back(std::make_unique<Surface>(platform, "Cube", Vector2i{ 1280, 720 }, true, largeObjectCount));
+    if (!*surfaces.front())
+        return EXIT_FAILURE;
+
+    ClusteredLighting lighting{ MaxLightCount };
+    if (!lighting)
+        return EXIT_FAILURE;
+
+    ThreadPool threadPool;
+    OcclusionRasterizer rasterizer{ threadPool };
+
+    Spheres spheres;
+    if (!*spheres.impostor)
+        return EXIT_FAILURE;
+
+    SmallObjects smallObjects;
+
+    LodSelector lodSelector{ threadPool };
+
+    DebugDraw debugDraw;
+    if (!debugDraw)
+        return EXIT_FAILURE;
+
+    PostProcessing postProcessing;
+    if (!postProcessing)
+        return EXIT_FAILURE;
+
+    DynamicResolution resolution;
+
+    MultiView multiView;
+
+    UniformRing uniforms;
+
+    Scene scene{
+        .library = library,
+        .mainProgram = mainProgram,
+        .instancedProgram = instancedProgram,
+        .depthProgram = depthProgram,
+        .instancedDepthProgram = instancedDepthProgram,
+        .pullingProgram = pullingProgram,
+        .pullingDepthProgram = pullingDepthProgram,
+        .impostorProgram = impostorProgram,
+        .mesh = mesh,
+        .field = field,
+        .rasterizer = rasterizer,
+        .largeObjects = largeObjects,
+        .lighting = lighting,
+        .spheres = spheres,
+        .smallObjects = smallObjects,
+        .lodSelector = lodSelector,
+        .debugDraw = debugDraw,
+        .threadPool = threadPool,
+        .postProcessing = postProcessing,
+        .resolution = resolution,
+        .multiView = multiView,
+        .uniforms = uniforms
+    };
 
     std::chrono::time_point nextFrame = std::chrono::system_clock::now() + FrameTime{ 1 };
 
-    while (!window.shouldClose()) {
-        window.beginFrame();
+    while (!surfaces.front()->window.shouldClose()) {
+        platform.beginFrame();
+        library.update();
+
+        const bool overlay = platform.isOverlayVisible();
+
+        // Secondary windows render the scene on their own, at their own size.
+        surfaces.erase(std::remove_if(surfaces.begin() + 1, surfaces.end(), [](const std::unique_ptr<Surface>& surface) {
+            return surface->window.shouldClose();
+        }),
+            surfaces.end());
+
+        int secondaryCount = surfaces.size() - 1;
+        if (overlay)
+            ImGui::SliderInt("Secondary windows", &secondaryCount, 0, MaxSecondaryWindowCount);
+
+        surfaces.resize(std::min<std::size_t>(surfaces.size(), secondaryCount + 1));
+        while (static_cast<int>(surfaces.size()) <= secondaryCount) {
+            const std::string title = "Cube " + std::to_string(surfaces.size() + 1);
+            surfaces.push_back(std::make_unique<Surface>(platform, title, Vector2i{ 640, 360 }, false, largeObjectCount));
+            if (!*surfaces.back()) {
+                surfaces.pop_back();
+                break;
+            }
+        }
+
+        std::vector<Surface*> visibleSurfaces;
+        for (const std::unique_ptr<Surface>& surface : surfaces) {
+            const Vector2i size = surface->window.getSize();
+            if (size.x == 0 || size.y == 0)
+                continue;
+
+            const int width = std::max(static_cast<int>(size.x * resolution.getScale()), 1);
+            const int height = std::max(static_cast<int>(size.y * resolution.getScale()), 1);
+            surface->framebuffer.resize(Vector2i{ width, height });
+            surface->output.resize(size);
+
+            visibleSurfaces.push_back(surface.get());
+        }
+
+        Surface& primary = *surfaces.front();
+        const Frame frame = update(primary.framebuffer.getSize(), overlay, scene);
+
+        uniforms.begin();
+        resolution.begin();
+
+        for (Surface* surface : visibleSurfaces) {
+            const Vector2i& renderSize = surface->framebuffer.getSize();
+            surface->framebuffer.bind();
+            glViewport(0, 0, renderSize.x, renderSize.y);
+
+            render(frame, *surface, overlay && surface == &primary, scene);
+        }
+
+        resolution.end();
+        uniforms.end();
+
+        primary.output.bind();
+        platform.renderOverlay();
+
+        // Commands of different contexts are only ordered through a fence,
+        // which must be flushed to be visible to the other contexts. A single
+        // one covers the outputs of every window.
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+
+        // Only the primary window waits for vertical sync, last.
+        for (auto it = visibleSurfaces.rbegin(); it != visibleSurfaces.rend(); ++it)
+            (*it)->window.present((*it)->output, fence);
 
-        const Vector2i size = window.getSize();
-        if (size.x != 0 && size.y != 0)
-            render(size, shader, mesh);
+        glDeleteSync(fence);
 
-        window.endFrame();
+        DeletionQueue::retire();
 
         std::this_thread::sleep_until(nextFrame);
         nextFrame += FrameTime{ 1 };
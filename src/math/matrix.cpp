@@ -1,4 +1,5 @@
 #include "math/matrix.hpp"
+#include <array>
 #include <cmath>
 #include "math/vector.hpp"
 #include "utils/assertion.hpp"
@@ -129,6 +130,18 @@ Matrix4f operator*(const Matrix4f& lhs, const Matrix4f& rhs)
     return result;
 }
 
+Vector4f operator*(const Matrix4f& lhs, const Vector4f& rhs)
+{
+    const std::array<float, 16>& m = lhs.values;
+
+    return Vector4f{
+        m[0] * rhs.x + m[4] * rhs.y + m[8] * rhs.z + m[12] * rhs.w,
+        m[1] * rhs.x + m[5] * rhs.y + m[9] * rhs.z + m[13] * rhs.w,
+        m[2] * rhs.x + m[6] * rhs.y + m[10] * rhs.z + m[14] * rhs.w,
+        m[3] * rhs.x + m[7] * rhs.y + m[11] * rhs.z + m[15] * rhs.w
+    };
+}
+
 Matrix4f transpose(const Matrix4f& m)
 {
     return Matrix4f{
@@ -1,7 +1,9 @@
 #include "mesh.hpp"
 #include <cstddef>
 #include <span>
+#include <vector>
 #include <glad/gl.h>
+#include "deletionqueue.hpp"
 #include "math/vector.hpp"
 #include "utils/assertion.hpp"
 
@@ -31,18 +33,52 @@ Mesh::Mesh(std::span<const Vertex> vertices, std::span<const unsigned int> indic
     glNamedBufferStorage(indexBuffer, indices.size_bytes(), indices.data(), 0);
     glVertexArrayElementBuffer(vertexArray, indexBuffer);
 
+    std::vector<Vector3f> positions;
+    positions.reserve(vertices.size());
+    for (const Vertex& vertex : vertices)
+        positions.push_back(vertex.position);
+
+    glCreateVertexArrays(1, &positionVertexArray);
+
+    glCreateBuffers(1, &positionBuffer);
+    glNamedBufferStorage(positionBuffer, positions.size() * sizeof(Vector3f), positions.data(), 0);
+    glVertexArrayVertexBuffer(positionVertexArray, 0, positionBuffer, 0, sizeof(Vector3f));
+
+    glEnableVertexArrayAttrib(positionVertexArray, 0);
+    glVertexArrayAttribFormat(positionVertexArray, 0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(positionVertexArray, 0, 0);
+
+    glVertexArrayElementBuffer(positionVertexArray, indexBuffer);
+
     count = indices.size();
+
+    for (const Vertex& vertex : vertices)
+        bounds.extend(vertex.position);
 }
 
 Mesh::~Mesh()
 {
-    glDeleteBuffers(1, &indexBuffer);
-    glDeleteBuffers(1, &vertexBuffer);
-    glDeleteVertexArrays(1, &vertexArray);
+    DeletionQueue::enqueue(DeletionQueue::Type::Buffer, positionBuffer);
+    DeletionQueue::enqueue(DeletionQueue::Type::VertexArray, positionVertexArray);
+    DeletionQueue::enqueue(DeletionQueue::Type::Buffer, indexBuffer);
+    DeletionQueue::enqueue(DeletionQueue::Type::Buffer, vertexBuffer);
+    DeletionQueue::enqueue(DeletionQueue::Type::VertexArray, vertexArray);
 }
 
-void Mesh::draw() const
+void Mesh::draw(Stream stream) const
 {
-    glBindVertexArray(vertexArray);
+    glBindVertexArray(stream == Stream::Position ? positionVertexArray : vertexArray);
     glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, static_cast<const GLvoid*>(0));
 }
+
+void Mesh::drawInstanced(int instanceCount, int baseInstance, Stream stream) const
+{
+    glBindVertexArray(stream == Stream::Position ? positionVertexArray : vertexArray);
+    glDrawElementsInstancedBaseInstance(GL_TRIANGLES, count, GL_UNSIGNED_INT, static_cast<const GLvoid*>(0), instanceCount, baseInstance);
+}
+
+void Mesh::drawIndirect(GLintptr offset, Stream stream) const
+{
+    glBindVertexArray(stream == Stream::Position ? positionVertexArray : vertexArray);
+    glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<const GLvoid*>(offset));
+}
@@ -0,0 +1,239 @@
+#include "meshbatcher.hpp"
+#include <cstddef>
+#include <span>
+#include <vector>
+#include <glad/gl.h>
+#include "math/matrix.hpp"
+#include "mesh.hpp"
+#include "shader.hpp"
+#include "uniformring.hpp"
+#include "utils/assertion.hpp"
+#include "utils/simd.hpp"
+
+static void setupVertexArray(GLuint vertexArray, GLuint vertexBuffer, GLuint indexBuffer)
+{
+    glVertexArrayVertexBuffer(vertexArray, 0, vertexBuffer, 0, sizeof(Mesh::Vertex));
+
+    glEnableVertexArrayAttrib(vertexArray, 0);
+    glVertexArrayAttribFormat(vertexArray, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Mesh::Vertex, position));
+    glVertexArrayAttribBinding(vertexArray, 0, 0);
+
+    glEnableVertexArrayAttrib(vertexArray, 1);
+    glVertexArrayAttribFormat(vertexArray, 1, 3, GL_FLOAT, GL_FALSE, offsetof(Mesh::Vertex, color));
+    glVertexArrayAttribBinding(vertexArray, 1, 0);
+
+    glEnableVertexArrayAttrib(vertexArray, 2);
+    glVertexArrayAttribFormat(vertexArray, 2, 2, GL_FLOAT, GL_FALSE, offsetof(Mesh::Vertex, texCoords));
+    glVertexArrayAttribBinding(vertexArray, 2, 0);
+
+    glVertexArrayElementBuffer(vertexArray, indexBuffer);
+}
+
+// Positions are transformed as a combination of the matrix columns.
+static void transform(std::span<const Mesh::Vertex> source, const Matrix4f& model, Mesh::Vertex* destination)
+{
+    const Float4 c0 = Float4::load(&model.values[0]);
+    const Float4 c1 = Float4::load(&model.values[4]);
+    const Float4 c2 = Float4::load(&model.values[8]);
+    const Float4 c3 = Float4::load(&model.values[12]);
+
+    for (const Mesh::Vertex& vertex : source) {
+        const Vector3f& p = vertex.position;
+        const Float4 position = c0 * Float4{ p.x } + c1 * Float4{ p.y } + c2 * Float4{ p.z } + c3;
+
+        // The vertex only holds three floats, so the four-wide result goes
+        // through a local first.
+        float transformed[4];
+        position.store(transformed);
+
+        destination->position = Vector3f{ transformed[0], transformed[1], transformed[2] };
+        destination->color = vertex.color;
+        destination->texCoords = vertex.texCoords;
+        ++destination;
+    }
+}
+
+MeshBatcher::MeshBatcher(int dynamicVertexCapacity, int dynamicIndexCapacity)
+    : dynamicVertexCapacity{ dynamicVertexCapacity }
+    , dynamicIndexCapacity{ dynamicIndexCapacity }
+    , maxVertexCount{ 256 }
+    , staticVertexBuffer{ 0 }
+    , staticIndexBuffer{ 0 }
+    , staticIndexCount{ 0 }
+    , dynamicVertexCount{ 0 }
+    , dynamicIndexCount{ 0 }
+{
+    Assert(dynamicVertexCapacity > 0 && dynamicIndexCapacity > 0);
+
+    glCreateVertexArrays(1, &staticVertexArray);
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const GLsizeiptr vertexSize = FrameRing::FrameCount * dynamicVertexCapacity * sizeof(Mesh::Vertex);
+    const GLsizeiptr indexSize = FrameRing::FrameCount * dynamicIndexCapacity * sizeof(unsigned int);
+
+    glCreateBuffers(1, &dynamicVertexBuffer);
+    glNamedBufferStorage(dynamicVertexBuffer, vertexSize, nullptr, flags);
+    dynamicVertices = static_cast<Mesh::Vertex*>(glMapNamedBufferRange(dynamicVertexBuffer, 0, vertexSize, flags));
+
+    glCreateBuffers(1, &dynamicIndexBuffer);
+    glNamedBufferStorage(dynamicIndexBuffer, indexSize, nullptr, flags);
+    dynamicIndices = static_cast<unsigned int*>(glMapNamedBufferRange(dynamicIndexBuffer, 0, indexSize, flags));
+
+    glCreateVertexArrays(1, &dynamicVertexArray);
+    setupVertexArray(dynamicVertexArray, dynamicVertexBuffer, dynamicIndexBuffer);
+}
+
+MeshBatcher::~MeshBatcher()
+{
+    glUnmapNamedBuffer(dynamicIndexBuffer);
+    glUnmapNamedBuffer(dynamicVertexBuffer);
+    glDeleteVertexArrays(1, &dynamicVertexArray);
+    glDeleteBuffers(1, &dynamicIndexBuffer);
+    glDeleteBuffers(1, &dynamicVertexBuffer);
+
+    glDeleteVertexArrays(1, &staticVertexArray);
+    glDeleteBuffers(1, &staticIndexBuffer);
+    glDeleteBuffers(1, &staticVertexBuffer);
+}
+
+int MeshBatcher::addMesh(std::span<const Mesh::Vertex> vertices, std::span<const unsigned int> indices)
+{
+    Assert(!vertices.empty() && !indices.empty());
+
+    meshes.push_back(SourceMesh{
+        .firstVertex = static_cast<int>(sourceVertices.size()),
+        .vertexCount = static_cast<int>(vertices.size()),
+        .firstIndex = static_cast<int>(sourceIndices.size()),
+        .indexCount = static_cast<int>(indices.size()) });
+
+    sourceVertices.insert(sourceVertices.end(), vertices.begin(), vertices.end());
+    sourceIndices.insert(sourceIndices.end(), indices.begin(), indices.end());
+
+    return static_cast<int>(meshes.size() - 1);
+}
+
+void MeshBatcher::clearStatic()
+{
+    staticObjects.clear();
+    statistics.staticObjectCount = 0;
+}
+
+bool MeshBatcher::addStatic(int mesh, const Matrix4f& model)
+{
+    if (!isBatchable(mesh))
+        return false;
+
+    staticObjects.push_back(StaticObject{ .mesh = mesh, .model = model });
+
+    return true;
+}
+
+void MeshBatcher::buildStatic()
+{
+    std::vector<Mesh::Vertex> vertices;
+    std::vector<unsigned int> indices;
+
+    for (const StaticObject& object : staticObjects) {
+        const SourceMesh& mesh = meshes[object.mesh];
+        const unsigned int firstVertex = vertices.size();
+
+        vertices.resize(vertices.size() + mesh.vertexCount);
+        transform(std::span{ sourceVertices }.subspan(mesh.firstVertex, mesh.vertexCount), object.model, vertices.data() + firstVertex);
+
+        for (int i = 0; i < mesh.indexCount; ++i)
+            indices.push_back(firstVertex + sourceIndices[mesh.firstIndex + i]);
+    }
+
+    glDeleteBuffers(1, &staticIndexBuffer);
+    glDeleteBuffers(1, &staticVertexBuffer);
+    staticVertexBuffer = 0;
+    staticIndexBuffer = 0;
+    staticIndexCount = indices.size();
+    statistics.staticObjectCount = staticObjects.size();
+
+    if (indices.empty())
+        return;
+
+    glCreateBuffers(1, &staticVertexBuffer);
+    glNamedBufferStorage(staticVertexBuffer, vertices.size() * sizeof(Mesh::Vertex), vertices.data(), 0);
+
+    glCreateBuffers(1, &staticIndexBuffer);
+    glNamedBufferStorage(staticIndexBuffer, indices.size() * sizeof(unsigned int), indices.data(), 0);
+
+    setupVertexArray(staticVertexArray, staticVertexBuffer, staticIndexBuffer);
+}
+
+void MeshBatcher::beginDynamic()
+{
+    ring.advance();
+
+    dynamicVertexCount = 0;
+    dynamicIndexCount = 0;
+    statistics.dynamicObjectCount = 0;
+    statistics.refusedObjectCount = 0;
+}
+
+bool MeshBatcher::addDynamic(int mesh, const Matrix4f& model)
+{
+    const SourceMesh& source = meshes[mesh];
+
+    if (!isBatchable(mesh)
+        || dynamicVertexCount + source.vertexCount > dynamicVertexCapacity
+        || dynamicIndexCount + source.indexCount > dynamicIndexCapacity) {
+        ++statistics.refusedObjectCount;
+        return false;
+    }
+
+    const int frame = ring.getFrame();
+    Mesh::Vertex* vertices = dynamicVertices + frame * dynamicVertexCapacity + dynamicVertexCount;
+    unsigned int* indices = dynamicIndices + frame * dynamicIndexCapacity + dynamicIndexCount;
+
+    transform(std::span{ sourceVertices }.subspan(source.firstVertex, source.vertexCount), model, vertices);
+
+    // Relative to the region, which is selected with the base vertex.
+    for (int i = 0; i < source.indexCount; ++i)
+        indices[i] = dynamicVertexCount + sourceIndices[source.firstIndex + i];
+
+    dynamicVertexCount += source.vertexCount;
+    dynamicIndexCount += source.indexCount;
+    ++statistics.dynamicObjectCount;
+
+    return true;
+}
+
+void MeshBatcher::draw(Shader& shader, UniformRing& uniforms, int viewCount)
+{
+    Assert(viewCount > 0);
+
+    uniforms.bindDraw(Matrix4f{});
+    shader.bind();
+
+    statistics.drawCount = 0;
+
+    if (staticIndexCount > 0) {
+        glBindVertexArray(staticVertexArray);
+        glDrawElementsInstanced(GL_TRIANGLES, staticIndexCount, GL_UNSIGNED_INT, static_cast<const GLvoid*>(0), viewCount);
+        ++statistics.drawCount;
+    }
+
+    if (dynamicIndexCount > 0) {
+        const int frame = ring.getFrame();
+        const GLintptr indexOffset = frame * dynamicIndexCapacity * sizeof(unsigned int);
+
+        glBindVertexArray(dynamicVertexArray);
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, dynamicIndexCount, GL_UNSIGNED_INT, reinterpret_cast<const GLvoid*>(indexOffset), viewCount, frame * dynamicVertexCapacity);
+        ++statistics.drawCount;
+
+        // Guards the region until the last draw of the frame has completed.
+        ring.fence();
+    }
+
+    statistics.savedDrawCount = statistics.staticObjectCount + statistics.dynamicObjectCount - statistics.drawCount;
+}
+
+bool MeshBatcher::isBatchable(int mesh) const
+{
+    Assert(mesh >= 0 && mesh < static_cast<int>(meshes.size()));
+
+    return meshes[mesh].vertexCount <= maxVertexCount;
+}
@@ -0,0 +1,114 @@
+#include "multiview.hpp"
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <glad/gl.h>
+#include <spdlog/spdlog.h>
+#include "math/matrix.hpp"
+#include "math/vector.hpp"
+#include "utils/assertion.hpp"
+#include "utils/glextensions.hpp"
+
+static constexpr float MinDepth = 1e-3f;
+
+MultiView::MultiView()
+    : supported{ hasExtension("GL_ARB_shader_viewport_layer_array") }
+    , viewCount{ 0 }
+    , frustum{}
+    , uniforms{}
+    , viewports{}
+{
+    if (!supported)
+        spdlog::warn("GL_ARB_shader_viewport_layer_array is not supported, multi-view rendering is disabled");
+
+    glCreateBuffers(1, &uniformBuffer);
+    glNamedBufferStorage(uniformBuffer, sizeof(Uniforms), nullptr, GL_DYNAMIC_STORAGE_BIT);
+}
+
+MultiView::~MultiView()
+{
+    glDeleteBuffers(1, &uniformBuffer);
+}
+
+Vector2i MultiView::getGridSize(int viewCount)
+{
+    Assert(viewCount > 0 && viewCount <= MaxViewCount);
+
+    const int columns = viewCount > 1 ? 2 : 1;
+
+    return Vector2i{ columns, (viewCount + columns - 1) / columns };
+}
+
+void MultiView::setViews(std::span<const Matrix4f> rotations, float fovY, float zNear, float zFar, const Vector2i& size)
+{
+    Assert(!rotations.empty() && static_cast<int>(rotations.size()) <= MaxViewCount);
+    Assert(fovY > 0 && 0 < zNear && zNear < zFar);
+
+    viewCount = rotations.size();
+
+    const Vector2i grid = getGridSize(viewCount);
+    const Vector2f viewportSize{ static_cast<float>(size.x / grid.x), static_cast<float>(size.y / grid.y) };
+    const float aspect = viewportSize.x / viewportSize.y;
+    const float tanHalfFovY = std::tan(0.5f * fovY);
+    const Matrix4f projection = Matrix4f::perspective(fovY, aspect, zNear, zFar);
+
+    uniforms = Uniforms{};
+    uniforms.viewCount = viewCount;
+
+    Vector2f tanHalfFov{ 0, 0 };
+    float unionNear = zFar;
+    float unionFar = zNear;
+
+    for (int i = 0; i < viewCount; ++i) {
+        // Top left first.
+        const int column = i % grid.x;
+        const int row = grid.y - 1 - i / grid.x;
+        viewports[4 * i + 0] = column * viewportSize.x;
+        viewports[4 * i + 1] = row * viewportSize.y;
+        viewports[4 * i + 2] = viewportSize.x;
+        viewports[4 * i + 3] = viewportSize.y;
+
+        // The inverse of a rotation is its transpose.
+        uniforms.viewProjections[i] = projection * transpose(rotations[i]);
+
+        // Depth is linear over the near and far planes, so their corners bound
+        // the whole frustum.
+        for (int corner = 0; corner < 4; ++corner) {
+            const float x = corner & 1 ? tanHalfFovY * aspect : -tanHalfFovY * aspect;
+            const float y = corner & 2 ? tanHalfFovY : -tanHalfFovY;
+            const Vector4f direction = rotations[i] * Vector4f{ x, y, -1, 0 };
+
+            // Rays turned past the side of the eye cannot be enclosed, they
+            // are clamped to a very wide frustum.
+            const float depth = std::max(-direction.z, MinDepth);
+
+            tanHalfFov.x = std::max(tanHalfFov.x, std::abs(direction.x) / depth);
+            tanHalfFov.y = std::max(tanHalfFov.y, std::abs(direction.y) / depth);
+            unionNear = std::min(unionNear, depth * zNear);
+            unionFar = std::max(unionFar, depth * zFar);
+        }
+    }
+
+    frustum = Frustum{
+        .fovY = 2 * std::atan(tanHalfFov.y),
+        .aspect = tanHalfFov.x / tanHalfFov.y,
+        .zNear = unionNear,
+        .zFar = unionFar
+    };
+
+    glNamedBufferSubData(uniformBuffer, 0, sizeof(Uniforms), &uniforms);
+}
+
+void MultiView::bind() const
+{
+    Assert(supported && viewCount > 0);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, 0, uniformBuffer);
+    glViewportArrayv(0, viewCount, viewports);
+}
+
+void MultiView::unbind(const Vector2i& size) const
+{
+    // Sets every viewport back to the whole framebuffer.
+    glViewport(0, 0, size.x, size.y);
+}
@@ -0,0 +1,163 @@
+#include "platform.hpp"
+#include <memory>
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+#include <backends/imgui_impl_glfw.h>
+#include <glad/gl.h>
+#include <imgui.h>
+#include <spdlog/spdlog.h>
+#include "deletionqueue.hpp"
+#include "imguirenderer.hpp"
+#include "shader.hpp"
+#include "utils/assertion.hpp"
+
+#ifndef NDEBUG
+static void GLAPIENTRY debugMessageCallback(GLenum, GLenum type, GLuint, GLenum severity, GLsizei, const GLchar* message, const void*)
+{
+    if (severity == GL_DEBUG_SEVERITY_HIGH
+        || severity == GL_DEBUG_SEVERITY_MEDIUM
+        || severity == GL_DEBUG_SEVERITY_LOW) {
+        if (type == GL_DEBUG_TYPE_ERROR)
+            spdlog::error("{}", message);
+        else
+            spdlog::warn("{}", message);
+    }
+}
+#endif
+
+Platform::Platform()
+    : overlayWindow{ nullptr }
+    , overlayVisible{ true }
+    , overlayKeyDown{ false }
+{
+    glfwSetErrorCallback([](int, const char* description) {
+        spdlog::error("GLFW error: {}", description);
+    });
+
+    if (!glfwInit())
+        goto error_init;
+
+    // Hints persist, every window gets a compatible context.
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+#ifndef NDEBUG
+    glfwWindowHint(GLFW_CONTEXT_DEBUG, GLFW_TRUE);
+#endif
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    // Windows only blit into their default framebuffer.
+    glfwWindowHint(GLFW_DEPTH_BITS, 0);
+    glfwWindowHint(GLFW_STENCIL_BITS, 0);
+
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    context = glfwCreateWindow(1, 1, "", nullptr, nullptr);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (!context)
+        goto error_context;
+
+    glfwMakeContextCurrent(context);
+
+    if (!gladLoadGL(glfwGetProcAddress)) {
+        spdlog::error("Unable to load OpenGL");
+        goto error_glad;
+    }
+
+    Shader::setupParallelCompilation(glfwGetProcAddress);
+
+#ifndef NDEBUG
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    glDebugMessageCallback(debugMessageCallback, nullptr);
+#endif
+
+    glEnable(GL_CULL_FACE);
+    glEnable(GL_DEPTH_TEST);
+
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    imguiRenderer = std::make_unique<ImGuiRenderer>();
+
+    return;
+
+error_glad:
+    glfwDestroyWindow(context);
+error_context:
+    glfwTerminate();
+error_init:
+    context = nullptr;
+}
+
+Platform::~Platform()
+{
+    if (!context)
+        return;
+
+    Assert(!overlayWindow);
+
+    makeCurrent();
+
+    imguiRenderer.reset();
+    ImGui::DestroyContext();
+
+    DeletionQueue::flush();
+
+    glfwDestroyWindow(context);
+    glfwTerminate();
+}
+
+void Platform::makeCurrent() const
+{
+    Assert(context);
+
+    glfwMakeContextCurrent(context);
+}
+
+void Platform::attachOverlay(GLFWwindow* window)
+{
+    Assert(window && !overlayWindow);
+
+    ImGui_ImplGlfw_InitForOpenGL(window, true);
+    overlayWindow = window;
+}
+
+void Platform::detachOverlay()
+{
+    Assert(overlayWindow);
+
+    ImGui_ImplGlfw_Shutdown();
+    overlayWindow = nullptr;
+}
+
+void Platform::beginFrame()
+{
+    Assert(context);
+
+    glfwPollEvents();
+
+    if (!overlayWindow)
+        return;
+
+    // F1 toggles the overlay.
+    const bool overlayKeyPressed = glfwGetKey(overlayWindow, GLFW_KEY_F1) == GLFW_PRESS;
+    if (overlayKeyPressed && !overlayKeyDown)
+        overlayVisible = !overlayVisible;
+    overlayKeyDown = overlayKeyPressed;
+
+    // A hidden overlay costs nothing but dropping the input it received.
+    if (overlayVisible) {
+        ImGui_ImplGlfw_NewFrame();
+        ImGui::NewFrame();
+    } else {
+        ImGui::GetIO().ClearEventsQueue();
+    }
+}
+
+void Platform::renderOverlay()
+{
+    if (!isOverlayVisible())
+        return;
+
+    ImGui::Render();
+    if (*imguiRenderer)
+        imguiRenderer->render(*ImGui::GetDrawData());
+}
@@ -0,0 +1,67 @@
+#include "postprocessing.hpp"
+#include <glad/gl.h>
+#include "framebuffer.hpp"
+#include "math/vector.hpp"
+#include "shader.hpp"
+#include "utils/assertion.hpp"
+
+static constexpr int TileSize = 16;
+
+PostProcessing::PostProcessing()
+    : shader{ Shader::loadFromFile("shaders/post.cs.glsl") }
+    , upscaleShader{ Shader::loadFromFile("shaders/fullscreen.vs.glsl", "shaders/upscale.fs.glsl") }
+{
+    glCreateVertexArrays(1, &vertexArray);
+
+    glCreateSamplers(1, &sampler);
+    glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+PostProcessing::~PostProcessing()
+{
+    glDeleteSamplers(1, &sampler);
+    glDeleteVertexArrays(1, &vertexArray);
+}
+
+void PostProcessing::apply(GLuint source, GLuint destination, const Vector2i& size, const Settings& settings)
+{
+    Assert(shader && source != 0 && destination != 0);
+
+    shader.setUniform("exposure", settings.exposure);
+    shader.setUniform("contrast", settings.contrast);
+    shader.setUniform("saturation", settings.saturation);
+    shader.setUniform("tint", settings.tint);
+    shader.setUniform("vignette", settings.vignette);
+    shader.setUniform("sharpness", settings.sharpness);
+    shader.bind();
+
+    glBindTextureUnit(0, source);
+    glBindImageTexture(0, destination, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+
+    glDispatchCompute((size.x + TileSize - 1) / TileSize, (size.y + TileSize - 1) / TileSize, 1);
+}
+
+void PostProcessing::present(GLuint texture, const Framebuffer& target, float sharpness)
+{
+    Assert(upscaleShader && texture != 0);
+
+    upscaleShader.setUniform("sharpness", sharpness);
+    upscaleShader.bind();
+
+    glBindTextureUnit(0, texture);
+    glBindSampler(0, sampler);
+
+    const Vector2i& size = target.getSize();
+    target.bind();
+    glViewport(0, 0, size.x, size.y);
+    glDisable(GL_DEPTH_TEST);
+
+    glBindVertexArray(vertexArray);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    glEnable(GL_DEPTH_TEST);
+    glBindSampler(0, 0);
+}
@@ -0,0 +1,459 @@
+#include "rendergraph.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include <glad/gl.h>
+#include "gputimer.hpp"
+#include "math/vector.hpp"
+#include "utils/assertion.hpp"
+
+// Frames a pooled object may go unused before it is released.
+static constexpr int ReleaseDelay = 3;
+
+// Image stores and storage buffer writes are not visible to later accesses
+// without a barrier; everything else is ordered by GL itself.
+static bool isIncoherent(RenderGraph::Access access)
+{
+    return access == RenderGraph::Access::Image || access == RenderGraph::Access::Storage;
+}
+
+// Bits making incoherent writes visible to an access of the given kind.
+static GLbitfield getBarrierBits(RenderGraph::Access access, bool texture)
+{
+    switch (access) {
+    case RenderGraph::Access::Attachment:
+        return GL_FRAMEBUFFER_BARRIER_BIT;
+    case RenderGraph::Access::Sampled:
+        return GL_TEXTURE_FETCH_BARRIER_BIT;
+    case RenderGraph::Access::Image:
+        return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+    case RenderGraph::Access::Storage:
+        return GL_SHADER_STORAGE_BARRIER_BIT;
+    case RenderGraph::Access::Uniform:
+        return GL_UNIFORM_BARRIER_BIT;
+    case RenderGraph::Access::Vertex:
+        return GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT;
+    case RenderGraph::Access::Indirect:
+        return GL_COMMAND_BARRIER_BIT;
+    case RenderGraph::Access::Transfer:
+        return texture ? GL_TEXTURE_UPDATE_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT : GL_BUFFER_UPDATE_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT;
+    }
+
+    return 0;
+}
+
+static GLsizeiptr getPixelSize(GLenum format)
+{
+    switch (format) {
+    case GL_R8:
+        return 1;
+    case GL_RG8:
+    case GL_R16F:
+        return 2;
+    case GL_RGBA8:
+    case GL_SRGB8_ALPHA8:
+    case GL_RGB10_A2:
+    case GL_R11F_G11F_B10F:
+    case GL_RG16F:
+    case GL_R32F:
+    case GL_R32UI:
+    case GL_DEPTH24_STENCIL8:
+    case GL_DEPTH_COMPONENT32F:
+        return 4;
+    case GL_RGBA16F:
+    case GL_RG32F:
+        return 8;
+    case GL_RGBA32F:
+        return 16;
+    default:
+        Assert(false);
+        return 0;
+    }
+}
+
+static GLsizeiptr getTextureSize(const RenderGraph::TextureDescription& description)
+{
+    GLsizeiptr size = 0;
+    for (int level = 0; level < description.levelCount; ++level)
+        size += static_cast<GLsizeiptr>(std::max(description.size.x >> level, 1)) * std::max(description.size.y >> level, 1);
+
+    return size * getPixelSize(description.format);
+}
+
+RenderGraph::PassBuilder::PassBuilder(RenderGraph& graph, int pass)
+    : graph{ graph }
+    , pass{ pass }
+{
+}
+
+void RenderGraph::PassBuilder::read(Resource resource, Access access)
+{
+    Assert(resource >= 0 && resource < static_cast<int>(graph.resources.size()));
+
+    graph.passes[pass].uses.push_back(Use{ .resource = resource, .access = access, .write = false });
+}
+
+void RenderGraph::PassBuilder::write(Resource resource, Access access)
+{
+    Assert(resource >= 0 && resource < static_cast<int>(graph.resources.size()));
+
+    graph.passes[pass].uses.push_back(Use{ .resource = resource, .access = access, .write = true });
+}
+
+void RenderGraph::PassBuilder::setSideEffect()
+{
+    graph.passes[pass].sideEffect = true;
+}
+
+RenderGraph::RenderGraph()
+    : frame{ 0 }
+    , compiled{ false }
+{
+}
+
+RenderGraph::~RenderGraph()
+{
+    for (PhysicalResource& physical : pool) {
+        if (physical.type == Type::Texture)
+            glDeleteTextures(1, &physical.object);
+        else
+            glDeleteBuffers(1, &physical.object);
+    }
+}
+
+void RenderGraph::reset()
+{
+    resources.clear();
+    passes.clear();
+    order.clear();
+    compiled = false;
+}
+
+RenderGraph::Resource RenderGraph::importTexture(const std::string& name, GLuint texture)
+{
+    resources.push_back(ResourceNode{ .name = name, .type = Type::Texture, .imported = true, .output = false, .texture = {}, .size = 0, .object = texture });
+
+    return static_cast<Resource>(resources.size() - 1);
+}
+
+RenderGraph::Resource RenderGraph::importBuffer(const std::string& name, GLuint buffer)
+{
+    resources.push_back(ResourceNode{ .name = name, .type = Type::Buffer, .imported = true, .output = false, .texture = {}, .size = 0, .object = buffer });
+
+    return static_cast<Resource>(resources.size() - 1);
+}
+
+RenderGraph::Resource RenderGraph::createTexture(const std::string& name, const TextureDescription& description)
+{
+    Assert(description.size.x > 0 && description.size.y > 0 && description.levelCount > 0);
+
+    resources.push_back(ResourceNode{ .name = name, .type = Type::Texture, .imported = false, .output = false, .texture = description, .size = getTextureSize(description), .object = 0 });
+
+    return static_cast<Resource>(resources.size() - 1);
+}
+
+RenderGraph::Resource RenderGraph::createBuffer(const std::string& name, GLsizeiptr size)
+{
+    Assert(size > 0);
+
+    resources.push_back(ResourceNode{ .name = name, .type = Type::Buffer, .imported = false, .output = false, .texture = {}, .size = size, .object = 0 });
+
+    return static_cast<Resource>(resources.size() - 1);
+}
+
+void RenderGraph::markOutput(Resource resource)
+{
+    Assert(resource >= 0 && resource < static_cast<int>(resources.size()));
+
+    resources[resource].output = true;
+}
+
+void RenderGraph::addPass(const std::string& name, const Setup& setup, Execute execute)
+{
+    passes.push_back(PassNode{ .name = name, .uses = {}, .execute = std::move(execute), .sideEffect = false, .culled = false, .barriers = 0 });
+
+    PassBuilder builder{ *this, static_cast<int>(passes.size() - 1) };
+    setup(builder);
+}
+
+void RenderGraph::compile()
+{
+    ++frame;
+
+    cullPasses();
+    orderPasses();
+    releaseUnused();
+    allocateTransients();
+
+    statistics.passCount = static_cast<int>(passes.size());
+    statistics.culledPassCount = static_cast<int>(passes.size() - order.size());
+    statistics.barrierCount = static_cast<int>(std::count_if(passes.begin(), passes.end(), [](const PassNode& pass) {
+        return !pass.culled && pass.barriers != 0;
+    }));
+
+    compiled = true;
+}
+
+void RenderGraph::execute()
+{
+    Assert(compiled);
+
+    timings.clear();
+
+    for (int index : order) {
+        const PassNode& pass = passes[index];
+        GpuTimer& timer = timers.try_emplace(pass.name).first->second;
+        const auto start = std::chrono::steady_clock::now();
+
+        timer.begin();
+
+        if (pass.barriers != 0)
+            glMemoryBarrier(pass.barriers);
+
+        glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, pass.name.c_str());
+        pass.execute(*this);
+        glPopDebugGroup();
+
+        timer.end();
+
+        const std::chrono::duration<float, std::milli> cpuTime = std::chrono::steady_clock::now() - start;
+        timings.push_back(PassTiming{ .name = pass.name, .milliseconds = timer.getMilliseconds(), .cpuMilliseconds = cpuTime.count() });
+    }
+}
+
+GLuint RenderGraph::getTexture(Resource resource) const
+{
+    Assert(resource >= 0 && resource < static_cast<int>(resources.size()) && resources[resource].type == Type::Texture);
+
+    return resources[resource].object;
+}
+
+GLuint RenderGraph::getBuffer(Resource resource) const
+{
+    Assert(resource >= 0 && resource < static_cast<int>(resources.size()) && resources[resource].type == Type::Buffer);
+
+    return resources[resource].object;
+}
+
+void RenderGraph::cullPasses()
+{
+    std::vector<bool> needed(resources.size());
+    for (std::size_t i = 0; i < resources.size(); ++i)
+        needed[i] = resources[i].output;
+
+    for (PassNode& pass : passes)
+        pass.culled = true;
+
+    // A pass is kept once something it writes is needed; what it reads then
+    // becomes needed in turn.
+    for (bool changed = true; changed;) {
+        changed = false;
+
+        for (auto pass = passes.rbegin(); pass != passes.rend(); ++pass) {
+            if (!pass->culled)
+                continue;
+
+            const bool used = pass->sideEffect || std::any_of(pass->uses.begin(), pass->uses.end(), [&](const Use& use) {
+                return use.write && needed[use.resource];
+            });
+            if (!used)
+                continue;
+
+            pass->culled = false;
+            changed = true;
+
+            for (const Use& use : pass->uses)
+                if (!use.write)
+                    needed[use.resource] = true;
+        }
+    }
+}
+
+void RenderGraph::orderPasses()
+{
+    // Passes touching a common resource, at least one of them writing it, keep
+    // their declaration order; independent passes may be reordered.
+    std::vector<std::vector<int>> successors(passes.size());
+    std::vector<int> predecessorCounts(passes.size(), 0);
+
+    for (std::size_t a = 0; a < passes.size(); ++a) {
+        if (passes[a].culled)
+            continue;
+
+        for (std::size_t b = a + 1; b < passes.size(); ++b) {
+            if (passes[b].culled)
+                continue;
+
+            const bool conflict = std::any_of(passes[a].uses.begin(), passes[a].uses.end(), [&](const Use& ua) {
+                return std::any_of(passes[b].uses.begin(), passes[b].uses.end(), [&](const Use& ub) {
+                    return ua.resource == ub.resource && (ua.write || ub.write);
+                });
+            });
+
+            if (conflict) {
+                successors[a].push_back(b);
+                ++predecessorCounts[b];
+            }
+        }
+    }
+
+    struct State {
+        bool dirty = false;
+        GLbitfield synchronized = 0;
+    };
+
+    std::vector<State> states(resources.size());
+
+    const auto getBarriers = [&](const PassNode& pass) {
+        GLbitfield barriers = 0;
+        for (const Use& use : pass.uses) {
+            const State& state = states[use.resource];
+            if (state.dirty)
+                barriers |= getBarrierBits(use.access, resources[use.resource].type == Type::Texture) & ~state.synchronized;
+        }
+
+        return barriers;
+    };
+
+    std::vector<int> ready;
+    for (std::size_t i = 0; i < passes.size(); ++i)
+        if (!passes[i].culled && predecessorCounts[i] == 0)
+            ready.push_back(i);
+
+    order.clear();
+
+    while (!ready.empty()) {
+        // Passes that can run without a barrier go first, delaying barriers
+        // so that they cover as many writes as possible.
+        auto next = std::find_if(ready.begin(), ready.end(), [&](int index) {
+            return getBarriers(passes[index]) == 0;
+        });
+        if (next == ready.end())
+            next = ready.begin();
+
+        const int index = *next;
+        ready.erase(next);
+
+        PassNode& pass = passes[index];
+        pass.barriers = getBarriers(pass);
+
+        // Barriers are global: they make every pending write visible.
+        if (pass.barriers != 0)
+            for (State& state : states)
+                if (state.dirty)
+                    state.synchronized |= pass.barriers;
+
+        for (const Use& use : pass.uses)
+            if (use.write)
+                states[use.resource] = isIncoherent(use.access) ? State{ .dirty = true, .synchronized = 0 } : State{};
+
+        order.push_back(index);
+
+        for (int successor : successors[index])
+            if (--predecessorCounts[successor] == 0)
+                ready.insert(std::lower_bound(ready.begin(), ready.end(), successor), successor);
+    }
+}
+
+void RenderGraph::allocateTransients()
+{
+    std::vector<int> firstUses(resources.size(), -1);
+    std::vector<int> lastUses(resources.size(), -1);
+
+    for (std::size_t position = 0; position < order.size(); ++position)
+        for (const Use& use : passes[order[position]].uses) {
+            if (firstUses[use.resource] < 0)
+                firstUses[use.resource] = position;
+            lastUses[use.resource] = position;
+        }
+
+    std::vector<Resource> transients;
+    for (std::size_t i = 0; i < resources.size(); ++i)
+        if (!resources[i].imported && firstUses[i] >= 0)
+            transients.push_back(i);
+
+    std::stable_sort(transients.begin(), transients.end(), [&](Resource a, Resource b) {
+        return firstUses[a] < firstUses[b];
+    });
+
+    for (PhysicalResource& physical : pool)
+        physical.busyUntil = -1;
+
+    statistics.transientCount = static_cast<int>(transients.size());
+    statistics.transientBytes = 0;
+
+    for (Resource index : transients) {
+        ResourceNode& resource = resources[index];
+
+        // Textures need an identical description, buffers take the smallest
+        // free one that is large enough.
+        int match = -1;
+        for (std::size_t i = 0; i < pool.size(); ++i) {
+            const PhysicalResource& physical = pool[i];
+            if (physical.type != resource.type || physical.busyUntil >= firstUses[index])
+                continue;
+
+            const bool compatible = resource.type == Type::Texture
+                ? physical.texture.format == resource.texture.format && physical.texture.size == resource.texture.size && physical.texture.levelCount == resource.texture.levelCount
+                : physical.size >= resource.size;
+
+            if (compatible && (match < 0 || physical.size < pool[match].size))
+                match = i;
+        }
+
+        if (match < 0) {
+            PhysicalResource physical{ .type = resource.type, .texture = resource.texture, .size = resource.size, .object = 0, .lastUsedFrame = frame, .busyUntil = -1 };
+
+            if (resource.type == Type::Texture) {
+                const TextureDescription& description = resource.texture;
+
+                glCreateTextures(GL_TEXTURE_2D, 1, &physical.object);
+                glTextureStorage2D(physical.object, description.levelCount, description.format, description.size.x, description.size.y);
+                glTextureParameteri(physical.object, GL_TEXTURE_MIN_FILTER, description.levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+                glTextureParameteri(physical.object, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTextureParameteri(physical.object, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTextureParameteri(physical.object, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            } else {
+                glCreateBuffers(1, &physical.object);
+                glNamedBufferStorage(physical.object, resource.size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+            }
+
+            pool.push_back(physical);
+            match = static_cast<int>(pool.size() - 1);
+        }
+
+        PhysicalResource& physical = pool[match];
+        physical.busyUntil = lastUses[index];
+        physical.lastUsedFrame = frame;
+
+        resource.object = physical.object;
+        statistics.transientBytes += resource.size;
+    }
+
+    statistics.physicalCount = 0;
+    statistics.physicalBytes = 0;
+    for (const PhysicalResource& physical : pool)
+        if (physical.lastUsedFrame == frame) {
+            ++statistics.physicalCount;
+            statistics.physicalBytes += physical.size;
+        }
+}
+
+void RenderGraph::releaseUnused()
+{
+    std::erase_if(pool, [&](PhysicalResource& physical) {
+        if (physical.lastUsedFrame >= frame - ReleaseDelay)
+            return false;
+
+        if (physical.type == Type::Texture)
+            glDeleteTextures(1, &physical.object);
+        else
+            glDeleteBuffers(1, &physical.object);
+
+        return true;
+    });
+}
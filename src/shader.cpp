@@ -1,14 +1,34 @@
 #include "shader.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <initializer_list>
+#include <iterator>
+#include <mutex>
 #include <optional>
+#include <span>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
 #include <glad/gl.h>
 #include <spdlog/spdlog.h>
 #define STB_INCLUDE_IMPLEMENTATION
+#define STB_INCLUDE_LINE_GLSL
 #include <stb_include.h>
+#include "deletionqueue.hpp"
 #include "math/matrix.hpp"
+#include "math/vector.hpp"
 #include "utils/assertion.hpp"
+#include "utils/glextensions.hpp"
 
 static char* stb_include_file_const(const char* filename, const char* inject, const char* path_to_includes, char error[256])
 {
@@ -38,23 +58,59 @@ static const char* getShaderTypeName(GLenum type)
         return "vertex";
     else if (type == GL_FRAGMENT_SHADER)
         return "fragment";
+    else if (type == GL_COMPUTE_SHADER)
+        return "compute";
 
     return "<unknown>";
 }
 
-static GLuint compileShader(GLenum type, const char* source)
+// GL_KHR_parallel_shader_compile is not part of the generated loader.
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+using PFNGLMAXSHADERCOMPILERTHREADSKHRPROC = void(GLAPIENTRY*)(GLuint count);
+
+static bool parallelCompilation = false;
+
+// Statuses are only read once the program is linked, so that the driver may
+// compile several shaders at once.
+static GLuint startCompiling(GLenum type, const char* source)
 {
-    Assert(type == GL_VERTEX_SHADER || type == GL_FRAGMENT_SHADER);
+    Assert(type == GL_VERTEX_SHADER || type == GL_FRAGMENT_SHADER || type == GL_COMPUTE_SHADER);
 
     const GLuint shader = glCreateShader(type);
 
     glShaderSource(shader, 1, &source, nullptr);
     glCompileShader(shader);
 
+    return shader;
+}
+
+static GLuint startLinking(std::initializer_list<GLuint> shaders)
+{
+    const GLuint program = glCreateProgram();
+
+    for (GLuint shader : shaders) {
+        Assert(shader != 0);
+        glAttachShader(program, shader);
+    }
+
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
+
+    return program;
+}
+
+static bool checkCompileStatus(GLuint shader)
+{
     GLint compileStatus;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
 
     if (compileStatus != GL_TRUE) {
+        GLint type;
+        glGetShaderiv(shader, GL_SHADER_TYPE, &type);
+
         GLint logLength;
         glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
 
@@ -63,28 +119,14 @@ static GLuint compileShader(GLenum type, const char* source)
 
         spdlog::error("Unable to compile {} shader: {}", getShaderTypeName(type), infoLog);
 
-        glDeleteShader(shader);
-
-        return 0;
+        return false;
     }
 
-    return shader;
+    return true;
 }
 
-static GLuint linkProgram(GLuint vs, GLuint fs)
+static bool checkLinkStatus(GLuint program)
 {
-    Assert(vs != 0 && fs != 0);
-
-    const GLuint program = glCreateProgram();
-
-    glAttachShader(program, vs);
-    glAttachShader(program, fs);
-
-    glLinkProgram(program);
-
-    glDetachShader(program, fs);
-    glDetachShader(program, vs);
-
     GLint linkStatus;
     glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
 
@@ -97,80 +139,452 @@ static GLuint linkProgram(GLuint vs, GLuint fs)
 
         spdlog::error("Unable to link shaders: {}", infoLog);
 
-        glDeleteProgram(program);
+        return false;
+    }
+
+    return true;
+}
+
+// Linked programs are cached on disk, keyed by their expanded sources and by
+// the driver, since binaries are only valid for the driver that made them.
+static constexpr const char* CacheDirectory = "shadercache";
+
+// FNV-1a, 64 bits.
+static std::uint64_t hashBytes(std::uint64_t hash, std::string_view bytes)
+{
+    for (char c : bytes)
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211u;
+
+    return hash;
+}
+
+// Empty if the driver supports no binary format.
+static std::filesystem::path getCachePath(std::initializer_list<std::string_view> sources)
+{
+    GLint formatCount;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount == 0)
+        return {};
+
+    // Sources never contain NUL, which separates the strings.
+    const std::string_view separator{ "", 1 };
+    std::uint64_t hash = 14695981039346656037u;
+
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+        const char* string = reinterpret_cast<const char*>(glGetString(name));
+        hash = hashBytes(hashBytes(hash, string ? string : ""), separator);
+    }
+
+    for (std::string_view source : sources)
+        hash = hashBytes(hashBytes(hash, source), separator);
+
+    std::ostringstream filename;
+    filename << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+
+    return std::filesystem::path{ CacheDirectory } / filename.str();
+}
+
+static GLuint loadBinary(const std::filesystem::path& path)
+{
+    if (path.empty())
+        return 0;
+
+    std::ifstream file{ path, std::ios::binary };
+
+    GLenum format;
+    if (!file.read(reinterpret_cast<char*>(&format), sizeof(format)))
+        return 0;
+
+    const std::vector<char> binary{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+    if (binary.empty())
+        return 0;
+
+    const GLuint program = glCreateProgram();
+    glProgramBinary(program, format, binary.data(), binary.size());
+
+    // Drivers may reject binaries even with a matching version string, the
+    // program is then compiled again.
+    GLint linkStatus;
+    glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
 
+    if (linkStatus != GL_TRUE) {
+        glDeleteProgram(program);
         return 0;
     }
 
     return program;
 }
 
-static GLuint compile(const char* vsSource, const char* fsSource)
+struct PendingBinary {
+    std::filesystem::path path;
+    GLenum format;
+    std::vector<char> binary;
+};
+
+// Linked binaries waiting to be written by Shader::writeBinaries().
+static std::mutex pendingBinariesMutex;
+static std::vector<PendingBinary> pendingBinaries;
+
+static void queueBinary(GLuint program, const std::filesystem::path& path)
 {
-    const GLuint vs = compileShader(GL_VERTEX_SHADER, vsSource);
-    const GLuint fs = compileShader(GL_FRAGMENT_SHADER, fsSource);
+    if (path.empty())
+        return;
 
-    const GLuint program = vs != 0 && fs != 0 ? linkProgram(vs, fs) : 0;
+    GLint length;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length == 0)
+        return;
 
-    glDeleteShader(fs);
-    glDeleteShader(vs);
+    PendingBinary pending{ .path = path, .format = 0, .binary = std::vector<char>(length) };
+    glGetProgramBinary(program, length, nullptr, &pending.format, pending.binary.data());
 
-    return program;
+    std::lock_guard lock{ pendingBinariesMutex };
+    pendingBinaries.push_back(std::move(pending));
+}
+
+static void writeBinary(const PendingBinary& pending)
+{
+    std::error_code error;
+    std::filesystem::create_directories(pending.path.parent_path(), error);
+
+    // Written aside and renamed, so that a partial file is never loaded.
+    std::filesystem::path temporaryPath = pending.path;
+    temporaryPath += ".tmp";
+
+    {
+        std::ofstream file{ temporaryPath, std::ios::binary };
+        file.write(reinterpret_cast<const char*>(&pending.format), sizeof(pending.format));
+        file.write(pending.binary.data(), pending.binary.size());
+
+        if (!file) {
+            spdlog::warn("Unable to write program binary '{}'", temporaryPath.string());
+            return;
+        }
+    }
+
+    std::filesystem::rename(temporaryPath, pending.path, error);
+    if (error)
+        spdlog::warn("Unable to write program binary '{}': {}", pending.path.string(), error.message());
 }
 
 Shader::Shader()
     : program{ 0 }
+    , stages{}
+    , ready{ false }
+{
+}
+
+Shader::Shader(Shader&& other) noexcept
+    : program{ std::exchange(other.program, 0) }
+    , stages{ std::exchange(other.stages, {}) }
+    , cachePath{ std::move(other.cachePath) }
+    , ready{ std::exchange(other.ready, false) }
+    , uniforms{ std::move(other.uniforms) }
 {
 }
 
 Shader::~Shader()
 {
-    glDeleteProgram(program);
+    release();
+}
+
+Shader& Shader::operator=(Shader&& other) noexcept
+{
+    if (this != &other) {
+        release();
+
+        program = std::exchange(other.program, 0);
+        stages = std::exchange(other.stages, {});
+        cachePath = std::move(other.cachePath);
+        ready = std::exchange(other.ready, false);
+        uniforms = std::move(other.uniforms);
+    }
+
+    return *this;
+}
+
+void Shader::setupParallelCompilation(GLADloadfunc load)
+{
+    if (!hasExtension("GL_KHR_parallel_shader_compile"))
+        return;
+
+    const auto maxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(load("glMaxShaderCompilerThreadsKHR"));
+    if (!maxShaderCompilerThreads)
+        return;
+
+    // Lets the driver pick the number of threads.
+    maxShaderCompilerThreads(0xFFFFFFFF);
+    parallelCompilation = true;
+}
+
+void Shader::writeBinaries()
+{
+    std::vector<PendingBinary> binaries;
+    {
+        std::lock_guard lock{ pendingBinariesMutex };
+        binaries.swap(pendingBinaries);
+    }
+
+    for (const PendingBinary& pending : binaries)
+        writeBinary(pending);
+}
+
+bool Shader::isReady()
+{
+    if (ready || program == 0)
+        return ready;
+
+    // Without the extension, finishing waits for the driver.
+    if (parallelCompilation) {
+        GLint completed;
+        glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &completed);
+        if (completed != GL_TRUE)
+            return false;
+    }
+
+    finishLinking();
+
+    return ready;
 }
 
 void Shader::bind() const
 {
-    Assert(program != 0);
+    Assert(ready);
 
     glUseProgram(program);
 }
 
-void Shader::setUniform(const std::string& name, const Matrix4f& m)
+void Shader::setUniform(Uniform<int> uniform, int i)
+{
+    const float value = std::bit_cast<float>(i);
+    if (uniform && updateCache(uniform.index, { &value, 1 }))
+        glProgramUniform1i(program, uniforms[uniform.index].location, i);
+}
+
+void Shader::setUniform(Uniform<float> uniform, float f)
+{
+    if (uniform && updateCache(uniform.index, { &f, 1 }))
+        glProgramUniform1f(program, uniforms[uniform.index].location, f);
+}
+
+void Shader::setUniform(Uniform<Vector2f> uniform, const Vector2f& v)
+{
+    const float value[] = { v.x, v.y };
+    if (uniform && updateCache(uniform.index, value))
+        glProgramUniform2f(program, uniforms[uniform.index].location, v.x, v.y);
+}
+
+void Shader::setUniform(Uniform<Vector3f> uniform, const Vector3f& v)
 {
-    Assert(program != 0);
+    const float value[] = { v.x, v.y, v.z };
+    if (uniform && updateCache(uniform.index, value))
+        glProgramUniform3f(program, uniforms[uniform.index].location, v.x, v.y, v.z);
+}
 
-    glProgramUniformMatrix4fv(program, getUniformLocation(name), 1, GL_FALSE, m.data());
+void Shader::setUniform(Uniform<Matrix4f> uniform, const Matrix4f& m)
+{
+    if (uniform && updateCache(uniform.index, { m.data(), 16 }))
+        glProgramUniformMatrix4fv(program, uniforms[uniform.index].location, 1, GL_FALSE, m.data());
+}
+
+Shader Shader::loadFromFile(const std::filesystem::path& vsFilename, const std::filesystem::path& fsFilename, Compilation compilation)
+{
+    return loadFromFile(vsFilename, fsFilename, {}, compilation);
 }
 
-Shader Shader::loadFromFile(const std::filesystem::path& vsFilename, const std::filesystem::path& fsFilename)
+Shader Shader::loadFromFile(const std::filesystem::path& vsFilename, const std::filesystem::path& fsFilename, std::span<const std::string_view> defines, Compilation compilation)
 {
-    const std::optional<std::string> vsSource = readFile(vsFilename);
-    const std::optional<std::string> fsSource = readFile(fsFilename);
+    std::optional<std::string> vsSource = readFile(vsFilename);
+    std::optional<std::string> fsSource = readFile(fsFilename);
     if (!vsSource || !fsSource)
         return Shader{};
 
-    return loadFromMemory(*vsSource, *fsSource);
+    injectDefines(*vsSource, defines);
+    injectDefines(*fsSource, defines);
+
+    return loadFromMemory(*vsSource, *fsSource, compilation);
 }
 
-Shader Shader::loadFromMemory(const std::string& vsSource, const std::string& fsSource)
+Shader Shader::loadFromFile(const std::filesystem::path& csFilename)
 {
-    const GLuint program = compile(vsSource.c_str(), fsSource.c_str());
+    const std::optional<std::string> csSource = readFile(csFilename);
+    if (!csSource)
+        return Shader{};
 
-    return Shader{ program };
+    return loadFromMemory(*csSource);
 }
 
-Shader::Shader(GLuint program)
+Shader Shader::loadFromMemory(const std::string& vsSource, const std::string& fsSource, Compilation compilation)
+{
+    const std::filesystem::path cachePath = getCachePath({ vsSource, fsSource });
+
+    if (const GLuint program = loadBinary(cachePath); program != 0)
+        return Shader{ program, {}, {}, Compilation::Blocking };
+
+    const GLuint vs = startCompiling(GL_VERTEX_SHADER, vsSource.c_str());
+    const GLuint fs = startCompiling(GL_FRAGMENT_SHADER, fsSource.c_str());
+
+    return Shader{ startLinking({ vs, fs }), { vs, fs }, cachePath, compilation };
+}
+
+Shader Shader::loadFromMemory(const std::string& csSource)
+{
+    const std::filesystem::path cachePath = getCachePath({ csSource });
+
+    if (const GLuint program = loadBinary(cachePath); program != 0)
+        return Shader{ program, {}, {}, Compilation::Blocking };
+
+    const GLuint cs = startCompiling(GL_COMPUTE_SHADER, csSource.c_str());
+
+    return Shader{ startLinking({ cs }), { cs, 0 }, cachePath, Compilation::Blocking };
+}
+
+// Line numbers are put back so that messages still point at the source
+// files.
+void Shader::injectDefines(std::string& source, std::span<const std::string_view> defines)
+{
+    if (defines.empty())
+        return;
+
+    std::string lines;
+    for (std::string_view define : defines)
+        lines.append("#define ").append(define).push_back('\n');
+
+    if (source.starts_with("#version")) {
+        const std::size_t end = source.find('\n');
+        source.insert(end == std::string::npos ? source.size() : end + 1, lines + "#line 2\n");
+    } else {
+        source.insert(0, lines + "#line 1\n");
+    }
+}
+
+Shader::Shader(GLuint program, const std::array<GLuint, 2>& stages, const std::filesystem::path& cachePath, Compilation compilation)
     : program{ program }
+    , stages{ stages }
+    , cachePath{ cachePath }
+    , ready{ false }
 {
+    if (compilation == Compilation::Blocking)
+        finishLinking();
 }
 
-GLint Shader::getUniformLocation(const std::string& name) const
+void Shader::release()
 {
-    Assert(program != 0);
+    for (GLuint stage : stages)
+        DeletionQueue::enqueue(DeletionQueue::Type::Shader, stage);
+    DeletionQueue::enqueue(DeletionQueue::Type::Program, program);
+}
+
+void Shader::finishLinking()
+{
+    bool compiled = true;
+    for (GLuint stage : stages)
+        if (stage != 0 && !checkCompileStatus(stage))
+            compiled = false;
+
+    // A failed compilation already explains the failed link.
+    const bool linked = compiled && checkLinkStatus(program);
+
+    for (GLuint& stage : stages) {
+        if (stage != 0) {
+            glDetachShader(program, stage);
+            glDeleteShader(stage);
+            stage = 0;
+        }
+    }
+
+    if (!linked) {
+        glDeleteProgram(program);
+        program = 0;
+        return;
+    }
+
+    // Restored binaries come without a cache path. Parallel programs finish
+    // linking mid-frame, so the file is written later by writeBinaries().
+    queueBinary(program, cachePath);
+    cachePath.clear();
+
+    reflectUniforms();
+    ready = true;
+}
+
+void Shader::reflectUniforms()
+{
+    GLint count;
+    glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+
+    uniforms.reserve(count);
+
+    for (GLint i = 0; i < count; ++i) {
+        const GLenum properties[] = { GL_NAME_LENGTH, GL_TYPE, GL_LOCATION, GL_BLOCK_INDEX };
+        GLint values[std::size(properties)];
+        glGetProgramResourceiv(program, GL_UNIFORM, i, std::size(properties), properties, std::size(values), nullptr, values);
+
+        // Block members are set through their buffer.
+        if (values[3] != -1 || values[2] == -1)
+            continue;
+
+        std::string name(values[0], '\0');
+        glGetProgramResourceName(program, GL_UNIFORM, i, values[0], nullptr, name.data());
+        name.resize(values[0] - 1);
+
+        // Arrays are reported as their first element.
+        if (name.ends_with("[0]"))
+            name.resize(name.size() - 3);
+
+        uniforms.push_back(UniformEntry{
+            .hash = hashName(name),
+            .location = values[2],
+            .type = static_cast<GLenum>(values[1]),
+            .cached = false,
+            .value = {} });
+    }
+
+    std::sort(uniforms.begin(), uniforms.end(), [](const UniformEntry& a, const UniformEntry& b) {
+        return a.hash < b.hash;
+    });
+
+    const auto collision = std::adjacent_find(uniforms.begin(), uniforms.end(), [](const UniformEntry& a, const UniformEntry& b) {
+        return a.hash == b.hash;
+    });
+    if (collision != uniforms.end())
+        spdlog::error("Uniform name hash collision ({:#010x})", collision->hash);
+    Assert(collision == uniforms.end());
+}
+
+int Shader::findUniform(UniformName name, GLenum type) const
+{
+    if (!ready)
+        return -1;
+
+    const auto entry = std::lower_bound(uniforms.begin(), uniforms.end(), name.getHash(), [](const UniformEntry& entry, std::uint32_t hash) {
+        return entry.hash < hash;
+    });
+
+    if (entry == uniforms.end() || entry->hash != name.getHash()) {
+        spdlog::warn("'{}' does not correspond to an active uniform variable", name.getName());
+        return -1;
+    }
+
+    if (entry->type != type) {
+        spdlog::warn("'{}' does not have the type it is set with", name.getName());
+        return -1;
+    }
+
+    return entry - uniforms.begin();
+}
+
+bool Shader::updateCache(int index, std::span<const float> value)
+{
+    UniformEntry& entry = uniforms[index];
+
+    // Bitwise, so that ints stored as floats compare exactly.
+    const std::size_t size = value.size_bytes();
+    if (entry.cached && std::memcmp(entry.value.data(), value.data(), size) == 0)
+        return false;
 
-    const GLint location = glGetUniformLocation(program, name.c_str());
-    if (location == -1)
-        spdlog::warn("'{}' does not correspond to an active uniform variable", name);
+    std::memcpy(entry.value.data(), value.data(), size);
+    entry.cached = true;
 
-    return location;
+    return true;
 }
@@ -0,0 +1,364 @@
+#include "shaderlibrary.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <set>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include "shader.hpp"
+#include "utils/assertion.hpp"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+static constexpr int MaxIncludeDepth = 32;
+
+static std::filesystem::path normalize(const std::filesystem::path& filename)
+{
+    std::error_code error;
+    const std::filesystem::path path = std::filesystem::absolute(filename, error);
+
+    return (error ? filename : path).lexically_normal();
+}
+
+// Returns the quoted file name of an include directive, or an empty view.
+static std::string_view parseInclude(std::string_view line)
+{
+    const auto skipSpaces = [&line] {
+        while (!line.empty() && (line.front() == ' ' || line.front() == '\t'))
+            line.remove_prefix(1);
+    };
+
+    skipSpaces();
+    if (!line.starts_with('#'))
+        return {};
+    line.remove_prefix(1);
+
+    skipSpaces();
+    if (!line.starts_with("include"))
+        return {};
+    line.remove_prefix(7);
+
+    skipSpaces();
+    if (!line.starts_with('"'))
+        return {};
+    line.remove_prefix(1);
+
+    const std::size_t end = line.find('"');
+    if (end == std::string_view::npos)
+        return {};
+
+    return line.substr(0, end);
+}
+
+static std::string getVariantName(const std::vector<std::filesystem::path>& sources, const std::vector<std::string>& keywords, std::uint32_t features)
+{
+    std::string name = sources.back().string();
+    for (std::size_t i = 0; i < keywords.size(); ++i)
+        if (features & (1u << i))
+            name.append(" ").append(keywords[i]);
+
+    return name;
+}
+
+ShaderLibrary::ShaderLibrary()
+    : inotifyDescriptor{ -1 }
+    , stopDescriptor{ -1 }
+{
+#ifdef __linux__
+    inotifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    stopDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (inotifyDescriptor < 0 || stopDescriptor < 0) {
+        spdlog::warn("Shader reloading disabled, inotify is not available");
+        return;
+    }
+
+    watcher = std::thread{ &ShaderLibrary::watch, this };
+#else
+    spdlog::info("Shader reloading is only available on Linux");
+#endif
+}
+
+ShaderLibrary::~ShaderLibrary()
+{
+    Shader::writeBinaries();
+
+#ifdef __linux__
+    if (watcher.joinable()) {
+        const std::uint64_t value = 1;
+        [[maybe_unused]] const ssize_t written = ::write(stopDescriptor, &value, sizeof(value));
+        watcher.join();
+    }
+
+    if (stopDescriptor >= 0)
+        close(stopDescriptor);
+    if (inotifyDescriptor >= 0)
+        close(inotifyDescriptor);
+#endif
+}
+
+Shader& ShaderLibrary::load(const std::filesystem::path& vsFilename, const std::filesystem::path& fsFilename, Shader::Compilation compilation)
+{
+    return getVariant(loadVariants(vsFilename, fsFilename, {}, compilation), 0);
+}
+
+Shader& ShaderLibrary::load(const std::filesystem::path& csFilename)
+{
+    Program& program = programs.emplace_back();
+    program.sources = { csFilename };
+    program.compilation = Shader::Compilation::Blocking;
+
+    return getVariant(static_cast<int>(programs.size()) - 1, 0);
+}
+
+int ShaderLibrary::loadVariants(const std::filesystem::path& vsFilename, const std::filesystem::path& fsFilename, std::span<const std::string_view> keywords, Shader::Compilation compilation)
+{
+    Assert(keywords.size() < 32);
+
+    Program& program = programs.emplace_back();
+    program.sources = { vsFilename, fsFilename };
+    program.keywords.assign(keywords.begin(), keywords.end());
+    program.compilation = compilation;
+
+    return static_cast<int>(programs.size()) - 1;
+}
+
+Shader& ShaderLibrary::getVariant(int index, std::uint32_t features)
+{
+    Assert(index >= 0 && index < static_cast<int>(programs.size()));
+
+    Program& program = programs[index];
+    Assert(features >> program.keywords.size() == 0);
+
+    std::unique_ptr<Shader>& variant = program.variants[features];
+    if (!variant) {
+        std::vector<std::filesystem::path> dependencies;
+        variant = std::make_unique<Shader>(compile(program, features, program.compilation, dependencies));
+        addDependencies(program, std::move(dependencies));
+    }
+
+    return *variant;
+}
+
+int ShaderLibrary::update()
+{
+    Shader::writeBinaries();
+
+    std::set<std::filesystem::path> changed;
+    {
+        std::lock_guard lock{ mutex };
+        changed.swap(changedFiles);
+    }
+
+    if (changed.empty())
+        return 0;
+
+    for (const std::filesystem::path& filename : changed)
+        files.erase(filename);
+
+    int reloadedCount = 0;
+    for (Program& program : programs) {
+        const bool affected = std::any_of(program.dependencies.begin(), program.dependencies.end(),
+            [&changed](const std::filesystem::path& dependency) { return changed.contains(dependency); });
+        if (!affected)
+            continue;
+
+        for (auto& [features, variant] : program.variants) {
+            std::vector<std::filesystem::path> dependencies;
+            Shader shader = compile(program, features, Shader::Compilation::Blocking, dependencies);
+            addDependencies(program, std::move(dependencies));
+
+            const std::string name = getVariantName(program.sources, program.keywords, features);
+            if (!shader) {
+                spdlog::warn("Keeping the previous program of {}", name);
+                continue;
+            }
+
+            *variant = std::move(shader);
+            ++reloadedCount;
+
+            spdlog::info("Reloaded {}", name);
+        }
+    }
+
+    return reloadedCount;
+}
+
+Shader ShaderLibrary::compile(const Program& program, std::uint32_t features, Shader::Compilation compilation, std::vector<std::filesystem::path>& dependencies)
+{
+    const std::vector<std::filesystem::path>& sources = program.sources;
+    Assert(sources.size() == 1 || sources.size() == 2);
+
+    std::vector<std::string_view> defines;
+    for (std::size_t i = 0; i < program.keywords.size(); ++i)
+        if (features & (1u << i))
+            defines.push_back(program.keywords[i]);
+
+    std::array<std::string, 2> expanded;
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+        if (!expand(normalize(sources[i]), 0, expanded[i], dependencies))
+            return Shader{};
+
+        Shader::injectDefines(expanded[i], defines);
+    }
+
+    if (sources.size() == 1)
+        return Shader::loadFromMemory(expanded[0]);
+
+    return Shader::loadFromMemory(expanded[0], expanded[1], compilation);
+}
+
+// Included files are numbered by their position in the dependencies in #line
+// directives, which is what compilers print in their messages. The stage
+// itself stays file 0, since nothing may precede its #version.
+bool ShaderLibrary::expand(const std::filesystem::path& filename, int depth, std::string& result, std::vector<std::filesystem::path>& dependencies)
+{
+    if (depth > MaxIncludeDepth) {
+        spdlog::error("Too many nested includes in {}", filename.string());
+        return false;
+    }
+
+    auto it = std::find(dependencies.begin(), dependencies.end(), filename);
+    if (it == dependencies.end())
+        it = dependencies.insert(dependencies.end(), filename);
+    const int fileIndex = depth == 0 ? 0 : static_cast<int>(std::distance(dependencies.begin(), it));
+    if (depth > 0)
+        result.append("#line 1 ").append(std::to_string(fileIndex)).push_back('\n');
+
+    const std::string* content = read(filename);
+    if (!content)
+        return false;
+
+    std::string_view remaining = *content;
+    int lineNumber = 1;
+    while (!remaining.empty()) {
+        const std::size_t end = remaining.find('\n');
+        const std::string_view line = remaining.substr(0, end);
+        remaining.remove_prefix(end == std::string_view::npos ? remaining.size() : end + 1);
+
+        const std::string_view include = parseInclude(line);
+        if (include.empty()) {
+            result.append(line);
+            result.push_back('\n');
+        } else {
+            const std::filesystem::path includeFilename = (filename.parent_path() / include).lexically_normal();
+
+            if (!expand(includeFilename, depth + 1, result, dependencies))
+                return false;
+            result.append("#line ").append(std::to_string(lineNumber + 1)).append(" ").append(std::to_string(fileIndex)).push_back('\n');
+        }
+
+        ++lineNumber;
+    }
+
+    return true;
+}
+
+const std::string* ShaderLibrary::read(const std::filesystem::path& filename)
+{
+    if (auto it = files.find(filename); it != files.end())
+        return &it->second;
+
+    std::ifstream file{ filename, std::ios::binary };
+    if (!file) {
+        spdlog::error("Cannot open {}", filename.string());
+        return nullptr;
+    }
+
+    std::ostringstream stream;
+    stream << file.rdbuf();
+
+    return &files.emplace(filename, std::move(stream).str()).first->second;
+}
+
+// Files are only ever added, those no longer included merely cause a
+// needless reload. A file that failed to open is kept as well, so that
+// fixing it triggers the next attempt.
+void ShaderLibrary::addDependencies(Program& program, std::vector<std::filesystem::path> dependencies)
+{
+    for (std::filesystem::path& dependency : dependencies)
+        if (std::find(program.dependencies.begin(), program.dependencies.end(), dependency) == program.dependencies.end())
+            program.dependencies.push_back(std::move(dependency));
+
+    watchDirectories(program.dependencies);
+}
+
+void ShaderLibrary::watchDirectories(const std::vector<std::filesystem::path>& dependencies)
+{
+#ifdef __linux__
+    if (!watcher.joinable())
+        return;
+
+    std::lock_guard lock{ mutex };
+    for (const std::filesystem::path& dependency : dependencies) {
+        const std::filesystem::path directory = dependency.parent_path();
+
+        // Watching a directory again returns the same descriptor.
+        const int descriptor = inotify_add_watch(inotifyDescriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (descriptor < 0) {
+            spdlog::warn("Cannot watch {}", directory.string());
+            continue;
+        }
+
+        directories[descriptor] = directory;
+    }
+#else
+    static_cast<void>(dependencies);
+#endif
+}
+
+// Editors either write files in place or rename a temporary over them, so
+// both are reported. Events are only collected here, programs are compiled
+// by update() on the GL thread.
+void ShaderLibrary::watch()
+{
+#ifdef __linux__
+    alignas(inotify_event) char buffer[4096];
+
+    for (;;) {
+        std::array<pollfd, 2> descriptors{ {
+            { inotifyDescriptor, POLLIN, 0 },
+            { stopDescriptor, POLLIN, 0 },
+        } };
+        if (poll(descriptors.data(), descriptors.size(), -1) < 0)
+            continue;
+
+        if (descriptors[1].revents & POLLIN)
+            return;
+
+        const ssize_t size = ::read(inotifyDescriptor, buffer, sizeof(buffer));
+        if (size <= 0)
+            continue;
+
+        std::lock_guard lock{ mutex };
+        for (ssize_t offset = 0; offset < size;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            const auto it = directories.find(event->wd);
+            if (it == directories.end() || event->len == 0)
+                continue;
+
+            changedFiles.insert(it->second / event->name);
+        }
+    }
+#endif
+}
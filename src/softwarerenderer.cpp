@@ -0,0 +1,324 @@
+#include "softwarerenderer.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "lighting/clusteredlighting.hpp"
+#include "math/matrix.hpp"
+#include "math/vector.hpp"
+#include "mesh.hpp"
+#include "utils/assertion.hpp"
+#include "utils/simd.hpp"
+#include "utils/threadpool.hpp"
+
+// Opaque black, like the GL path clearing to the default clear color.
+static constexpr std::uint32_t ClearColor = 0xff000000;
+
+static std::uint32_t pack(float r, float g, float b)
+{
+    const auto channel = [](float c) {
+        return static_cast<std::uint32_t>(std::clamp(c, 0.f, 1.f) * 255 + 0.5f);
+    };
+
+    return channel(r) | channel(g) << 8 | channel(b) << 16 | 0xff000000;
+}
+
+SoftwareRenderer::SoftwareRenderer(ThreadPool& threadPool, const Vector2i& size)
+    : threadPool{ threadPool }
+    , size{ size }
+    , tileCount{ (size.x + TileWidth - 1) / TileWidth, (size.y + TileHeight - 1) / TileHeight }
+    , ambient{ 0 }
+    , color(size.x * size.y, ClearColor)
+    , depth(size.x * size.y, 1.f)
+    , bins(tileCount.x * tileCount.y)
+{
+    Assert(size.x > 0 && size.y > 0 && size.x % 4 == 0);
+}
+
+void SoftwareRenderer::begin(const Matrix4f& projection, std::span<const ClusteredLighting::PointLight> lights, float ambient)
+{
+    this->projection = projection;
+    this->lights = lights;
+    this->ambient = ambient;
+
+    triangles.clear();
+    for (std::vector<int>& bin : bins)
+        bin.clear();
+
+    statistics = {};
+}
+
+void SoftwareRenderer::draw(std::span<const Mesh::Vertex> vertices, std::span<const unsigned int> indices, const Matrix4f& model)
+{
+    Assert(indices.size() % 3 == 0);
+
+    // main.vs.glsl, once per vertex.
+    transformed.resize(vertices.size());
+    for (std::size_t i = 0; i < vertices.size(); ++i) {
+        const Vector4f position = model * Vector4f{ vertices[i].position, 1 };
+
+        transformed[i] = Vertex{
+            .clip = projection * position,
+            .color = vertices[i].color,
+            .texCoords = vertices[i].texCoords,
+            .viewPosition = Vector3f{ position.x, position.y, position.z }
+        };
+    }
+
+    const auto interpolate = [](const Vertex& a, const Vertex& b, float t) {
+        return Vertex{
+            .clip = a.clip + t * (b.clip - a.clip),
+            .color = a.color + t * (b.color - a.color),
+            .texCoords = a.texCoords + t * (b.texCoords - a.texCoords),
+            .viewPosition = a.viewPosition + t * (b.viewPosition - a.viewPosition)
+        };
+    };
+
+    for (std::size_t i = 0; i < indices.size(); i += 3) {
+        const Vertex* triangle[3] = {
+            &transformed[indices[i]],
+            &transformed[indices[i + 1]],
+            &transformed[indices[i + 2]]
+        };
+
+        // Clip against the near plane (z >= -w). Depth beyond the far plane
+        // fails the test against the cleared depth, the other planes are
+        // handled by clamping to the screen.
+        Vertex polygon[4];
+        int vertexCount = 0;
+        for (int j = 0; j < 3; ++j) {
+            const Vertex& a = *triangle[j];
+            const Vertex& b = *triangle[(j + 1) % 3];
+            const float da = a.clip.z + a.clip.w;
+            const float db = b.clip.z + b.clip.w;
+
+            if (da >= 0)
+                polygon[vertexCount++] = a;
+            if ((da >= 0) != (db >= 0))
+                polygon[vertexCount++] = interpolate(a, b, da / (da - db));
+        }
+
+        for (int j = 2; j < vertexCount; ++j)
+            addTriangle(polygon[0], polygon[j - 1], polygon[j]);
+    }
+}
+
+void SoftwareRenderer::rasterize()
+{
+    threadPool.parallelFor(tileCount.x * tileCount.y, [this](int tile) {
+        rasterizeTile(tile);
+    });
+}
+
+void SoftwareRenderer::addTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2)
+{
+    Triangle triangle;
+
+    const Vertex* source[3] = { &v0, &v1, &v2 };
+    for (int i = 0; i < 3; ++i) {
+        const Vertex& v = *source[i];
+        const float inverseW = 1 / v.clip.w;
+
+        triangle.screen[i] = Vector3f{
+            (0.5f * v.clip.x * inverseW + 0.5f) * size.x,
+            (0.5f * v.clip.y * inverseW + 0.5f) * size.y,
+            0.5f * v.clip.z * inverseW + 0.5f
+        };
+        triangle.inverseW[i] = inverseW;
+        triangle.color[i] = v.color;
+        triangle.texCoords[i] = v.texCoords;
+        triangle.viewPosition[i] = v.viewPosition;
+    }
+
+    const Vector3f& s0 = triangle.screen[0];
+    const Vector3f& s1 = triangle.screen[1];
+    const Vector3f& s2 = triangle.screen[2];
+
+    // Counter-clockwise triangles are front facing, back faces are culled.
+    const float area = (s1.x - s0.x) * (s2.y - s0.y) - (s1.y - s0.y) * (s2.x - s0.x);
+    if (area <= 0)
+        return;
+
+    const float minX = std::max(std::min({ s0.x, s1.x, s2.x }), 0.f);
+    const float minY = std::max(std::min({ s0.y, s1.y, s2.y }), 0.f);
+    const float maxX = std::min(std::max({ s0.x, s1.x, s2.x }), size.x - 1.f);
+    const float maxY = std::min(std::max({ s0.y, s1.y, s2.y }), size.y - 1.f);
+    if (minX > maxX || minY > maxY)
+        return;
+
+    // Meshes carry no normals; faces are flat, which is what the derivatives
+    // of the view position give in main.fs.glsl.
+    const Vector3f& p0 = triangle.viewPosition[0];
+    const Vector3f& p1 = triangle.viewPosition[1];
+    const Vector3f& p2 = triangle.viewPosition[2];
+    triangle.normal = normalize(cross(p1 - p0, p2 - p0));
+    triangle.boundsMin = Vector3f{ std::min({ p0.x, p1.x, p2.x }), std::min({ p0.y, p1.y, p2.y }), std::min({ p0.z, p1.z, p2.z }) };
+    triangle.boundsMax = Vector3f{ std::max({ p0.x, p1.x, p2.x }), std::max({ p0.y, p1.y, p2.y }), std::max({ p0.z, p1.z, p2.z }) };
+
+    const int index = triangles.size();
+    triangles.push_back(triangle);
+    ++statistics.triangleCount;
+
+    const int x0 = static_cast<int>(minX);
+    const int y0 = static_cast<int>(minY);
+    const int x1 = static_cast<int>(maxX);
+    const int y1 = static_cast<int>(maxY);
+
+    for (int ty = y0 / TileHeight; ty <= y1 / TileHeight; ++ty)
+        for (int tx = x0 / TileWidth; tx <= x1 / TileWidth; ++tx) {
+            bins[ty * tileCount.x + tx].push_back(index);
+            ++statistics.binnedTriangleCount;
+        }
+}
+
+void SoftwareRenderer::rasterizeTile(int tile)
+{
+    const int tileX = (tile % tileCount.x) * TileWidth;
+    const int tileY = (tile / tileCount.x) * TileHeight;
+    const int tileWidth = std::min(TileWidth, size.x - tileX);
+    const int tileHeight = std::min(TileHeight, size.y - tileY);
+
+    for (int y = tileY; y < tileY + tileHeight; ++y) {
+        std::fill_n(color.data() + y * size.x + tileX, tileWidth, ClearColor);
+        std::fill_n(depth.data() + y * size.x + tileX, tileWidth, 1.f);
+    }
+
+    const Float4 laneX{ 0.5f, 1.5f, 2.5f, 3.5f };
+    std::vector<const ClusteredLighting::PointLight*> triangleLights;
+    triangleLights.reserve(lights.size());
+
+    for (int index : bins[tile]) {
+        const Triangle& triangle = triangles[index];
+        const Vector3f& v0 = triangle.screen[0];
+        const Vector3f& v1 = triangle.screen[1];
+        const Vector3f& v2 = triangle.screen[2];
+
+        // Edge functions E(x, y) = a * x + b * y + c, positive inside.
+        const float a0 = v1.y - v2.y, b0 = v2.x - v1.x, c0 = v1.x * v2.y - v1.y * v2.x;
+        const float a1 = v2.y - v0.y, b1 = v0.x - v2.x, c1 = v2.x * v0.y - v2.y * v0.x;
+        const float a2 = v0.y - v1.y, b2 = v1.x - v0.x, c2 = v0.x * v1.y - v0.y * v1.x;
+
+        // Depth is affine in screen space, interpolated from the normalized
+        // edge functions (barycentric coordinates).
+        const float inverseArea = 1 / (c0 + c1 + c2);
+        const float za = (a0 * v0.z + a1 * v1.z + a2 * v2.z) * inverseArea;
+        const float zb = (b0 * v0.z + b1 * v1.z + b2 * v2.z) * inverseArea;
+        const float zc = (c0 * v0.z + c1 * v1.z + c2 * v2.z) * inverseArea;
+
+        // Lights whose sphere reaches the view space bounds of the triangle.
+        triangleLights.clear();
+        for (const ClusteredLighting::PointLight& light : lights) {
+            const Vector3f closest{
+                std::clamp(light.position.x, triangle.boundsMin.x, triangle.boundsMax.x),
+                std::clamp(light.position.y, triangle.boundsMin.y, triangle.boundsMax.y),
+                std::clamp(light.position.z, triangle.boundsMin.z, triangle.boundsMax.z)
+            };
+            if (distanceSquared(closest, light.position) < light.radius * light.radius)
+                triangleLights.push_back(&light);
+        }
+
+        const int x0 = std::max(static_cast<int>(std::max(std::min({ v0.x, v1.x, v2.x }), 0.f)), tileX) & ~3;
+        const int y0 = std::max(static_cast<int>(std::max(std::min({ v0.y, v1.y, v2.y }), 0.f)), tileY);
+        const int x1 = std::min(static_cast<int>(std::min(std::max({ v0.x, v1.x, v2.x }), size.x - 1.f)) + 1, tileX + tileWidth);
+        const int y1 = std::min(static_cast<int>(std::min(std::max({ v0.y, v1.y, v2.y }), size.y - 1.f)) + 1, tileY + tileHeight);
+
+        const Float4 inverseW0{ triangle.inverseW[0] };
+        const Float4 inverseW1{ triangle.inverseW[1] };
+        const Float4 inverseW2{ triangle.inverseW[2] };
+        const Vector3f& normal = triangle.normal;
+
+        for (int y = y0; y < y1; ++y) {
+            const float py = y + 0.5f;
+            const Float4 e0y{ b0 * py + c0 };
+            const Float4 e1y{ b1 * py + c1 };
+            const Float4 e2y{ b2 * py + c2 };
+            const Float4 zy{ zb * py + zc };
+
+            std::uint32_t* colorRow = color.data() + y * size.x;
+            float* depthRow = depth.data() + y * size.x;
+
+            for (int x = x0; x < x1; x += 4) {
+                const Float4 px = Float4{ static_cast<float>(x) } + laneX;
+                const Float4 e0 = Float4{ a0 } * px + e0y;
+                const Float4 e1 = Float4{ a1 } * px + e1y;
+                const Float4 e2 = Float4{ a2 } * px + e2y;
+                const Float4 inside = (e0 >= Float4{ 0.f }) & (e1 >= Float4{ 0.f }) & (e2 >= Float4{ 0.f });
+                if (moveMask(inside) == 0)
+                    continue;
+
+                const Float4 z = Float4{ za } * px + zy;
+                const Float4 d = Float4::load(depthRow + x);
+                const Float4 passed = inside & (z < d);
+                const int mask = moveMask(passed);
+                if (mask == 0)
+                    continue;
+
+                select(passed, z, d).store(depthRow + x);
+
+                // Barycentric coordinates weighted by 1 / w for perspective
+                // correct attributes.
+                const Float4 w0 = e0 * Float4{ inverseArea } * inverseW0;
+                const Float4 w1 = e1 * Float4{ inverseArea } * inverseW1;
+                const Float4 w2 = e2 * Float4{ inverseArea } * inverseW2;
+                const Float4 inverseSum = Float4{ 1.f } / (w0 + w1 + w2);
+                const Float4 l1 = w1 * inverseSum;
+                const Float4 l2 = w2 * inverseSum;
+
+                const auto interpolate = [&](float f0, float f1, float f2) {
+                    return Float4{ f0 } + l1 * Float4{ f1 - f0 } + l2 * Float4{ f2 - f0 };
+                };
+
+                const Float4 u = interpolate(triangle.texCoords[0].x, triangle.texCoords[1].x, triangle.texCoords[2].x);
+                const Float4 v = interpolate(triangle.texCoords[0].y, triangle.texCoords[1].y, triangle.texCoords[2].y);
+                const Float4 inner = (u > Float4{ 0.05f }) & (u < Float4{ 0.95f }) & (v > Float4{ 0.05f }) & (v < Float4{ 0.95f });
+                const Float4 multiplier = select(inner, Float4{ 1.f }, Float4{ 0.2f });
+
+                const Float4 albedoR = multiplier * interpolate(triangle.color[0].x, triangle.color[1].x, triangle.color[2].x);
+                const Float4 albedoG = multiplier * interpolate(triangle.color[0].y, triangle.color[1].y, triangle.color[2].y);
+                const Float4 albedoB = multiplier * interpolate(triangle.color[0].z, triangle.color[1].z, triangle.color[2].z);
+
+                const Float4 positionX = interpolate(triangle.viewPosition[0].x, triangle.viewPosition[1].x, triangle.viewPosition[2].x);
+                const Float4 positionY = interpolate(triangle.viewPosition[0].y, triangle.viewPosition[1].y, triangle.viewPosition[2].y);
+                const Float4 positionZ = interpolate(triangle.viewPosition[0].z, triangle.viewPosition[1].z, triangle.viewPosition[2].z);
+
+                Float4 r = Float4{ ambient } * albedoR;
+                Float4 g = Float4{ ambient } * albedoG;
+                Float4 b = Float4{ ambient } * albedoB;
+
+                for (const ClusteredLighting::PointLight* light : triangleLights) {
+                    const Float4 toLightX = Float4{ light->position.x } - positionX;
+                    const Float4 toLightY = Float4{ light->position.y } - positionY;
+                    const Float4 toLightZ = Float4{ light->position.z } - positionZ;
+                    const Float4 distanceSquared = toLightX * toLightX + toLightY * toLightY + toLightZ * toLightZ;
+                    const Float4 radiusSquared{ light->radius * light->radius };
+                    const Float4 reached = distanceSquared < radiusSquared;
+                    if (moveMask(passed & reached) == 0)
+                        continue;
+
+                    // Inverse square falloff windowed to reach zero at the
+                    // light radius.
+                    const Float4 ratio = distanceSquared / radiusSquared;
+                    const Float4 window = (Float4{ 1.f } - ratio * ratio) * (Float4{ 1.f } - ratio * ratio);
+                    const Float4 attenuation = window / (distanceSquared + Float4{ 1.f });
+                    const Float4 cosine = Float4{ normal.x } * toLightX + Float4{ normal.y } * toLightY + Float4{ normal.z } * toLightZ;
+                    const Float4 diffuse = max(cosine / sqrt(distanceSquared), Float4{ 0.f });
+                    const Float4 scale = select(reached, Float4{ light->intensity } * attenuation * diffuse, Float4{ 0.f });
+
+                    r = r + scale * Float4{ light->color.x } * albedoR;
+                    g = g + scale * Float4{ light->color.y } * albedoG;
+                    b = b + scale * Float4{ light->color.z } * albedoB;
+                }
+
+                float red[4], green[4], blue[4];
+                r.store(red);
+                g.store(green);
+                b.store(blue);
+
+                for (int i = 0; i < 4; ++i)
+                    if (mask & (1 << i))
+                        colorRow[x + i] = pack(red[i], green[i], blue[i]);
+            }
+        }
+    }
+}
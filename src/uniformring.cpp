@@ -0,0 +1,84 @@
+#include "uniformring.hpp"
+#include <cstddef>
+#include <cstring>
+#include <glad/gl.h>
+#include "deletionqueue.hpp"
+#include "framering.hpp"
+#include "math/matrix.hpp"
+#include "utils/assertion.hpp"
+
+UniformRing::UniformRing(int capacity)
+    : capacity{ capacity }
+    , offset{ 0 }
+{
+    Assert(capacity > 0);
+
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+    createBuffer();
+}
+
+UniformRing::~UniformRing()
+{
+    glUnmapNamedBuffer(buffer);
+    glDeleteBuffers(1, &buffer);
+}
+
+void UniformRing::begin()
+{
+    ring.advance();
+    offset = 0;
+}
+
+void UniformRing::end()
+{
+    ring.fence();
+}
+
+void UniformRing::bindFrame(const Matrix4f& projection, float time)
+{
+    const FrameUniforms uniforms{ .projection = projection, .time = time, .padding = {} };
+    bind(FrameBinding, &uniforms, sizeof(uniforms));
+}
+
+void UniformRing::bindDraw(const Matrix4f& model)
+{
+    const DrawUniforms uniforms{ .model = model };
+    bind(DrawBinding, &uniforms, sizeof(uniforms));
+}
+
+void UniformRing::bind(GLuint binding, const void* block, int size)
+{
+    // Rare, the frame carries on in a larger buffer. Blocks already bound
+    // keep the previous one alive until the GPU is done with them.
+    if (offset + size > capacity) {
+        DeletionQueue::enqueue(DeletionQueue::Type::Buffer, buffer);
+
+        while (offset + size > capacity)
+            capacity *= 2;
+        createBuffer();
+
+        offset = 0;
+        ++statistics.growCount;
+    }
+
+    const GLintptr regionOffset = ring.getFrame() * capacity + offset;
+    std::memcpy(data + regionOffset, block, size);
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, regionOffset, size);
+
+    offset += (size + alignment - 1) / alignment * alignment;
+}
+
+void UniformRing::createBuffer()
+{
+    // Every region starts aligned.
+    capacity = (capacity + alignment - 1) / alignment * alignment;
+
+    const GLsizeiptr size = FrameRing::FrameCount * capacity;
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    // The name is deleted mapped when the ring grows, which unmaps it.
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, size, nullptr, flags);
+    data = static_cast<std::byte*>(glMapNamedBufferRange(buffer, 0, size, flags));
+}
@@ -0,0 +1,15 @@
+#include "utils/glextensions.hpp"
+#include <cstring>
+#include <glad/gl.h>
+
+bool hasExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+    for (GLint i = 0; i < count; ++i)
+        if (std::strcmp(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)), name) == 0)
+            return true;
+
+    return false;
+}
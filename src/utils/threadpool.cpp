@@ -0,0 +1,100 @@
+#include "utils/threadpool.hpp"
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "utils/assertion.hpp"
+
+ThreadPool::ThreadPool(int threadCount)
+    : function{ nullptr }
+    , count{ 0 }
+    , next{ 0 }
+    , activeWorkers{ 0 }
+    , generation{ 0 }
+    , stopping{ false }
+{
+    threadCount = std::max(threadCount, 1);
+
+    workers.reserve(threadCount - 1);
+    for (int i = 1; i < threadCount; ++i)
+        workers.emplace_back(&ThreadPool::run, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        const std::lock_guard lock{ mutex };
+        stopping = true;
+    }
+
+    wakeCondition.notify_all();
+
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& function)
+{
+    Assert(count >= 0);
+
+    if (count == 0)
+        return;
+
+    if (count == 1 || workers.empty()) {
+        for (int i = 0; i < count; ++i)
+            function(i);
+        return;
+    }
+
+    const std::lock_guard batchLock{ batchMutex };
+
+    {
+        const std::lock_guard lock{ mutex };
+        this->function = &function;
+        this->count = count;
+        next = 0;
+        activeWorkers = workers.size();
+        ++generation;
+    }
+
+    wakeCondition.notify_all();
+
+    work();
+
+    std::unique_lock lock{ mutex };
+    doneCondition.wait(lock, [this] { return activeWorkers == 0; });
+
+    this->function = nullptr;
+}
+
+void ThreadPool::run()
+{
+    unsigned int lastGeneration = 0;
+
+    while (true) {
+        {
+            std::unique_lock lock{ mutex };
+            wakeCondition.wait(lock, [&] { return stopping || generation != lastGeneration; });
+
+            if (stopping)
+                return;
+
+            lastGeneration = generation;
+        }
+
+        work();
+
+        {
+            const std::lock_guard lock{ mutex };
+            --activeWorkers;
+        }
+
+        doneCondition.notify_one();
+    }
+}
+
+void ThreadPool::work()
+{
+    for (int i = next++; i < count; i = next++)
+        (*function)(i);
+}
@@ -1,82 +1,36 @@
 #include "window.hpp"
+#include <algorithm>
 #include <string>
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
-#include <backends/imgui_impl_glfw.h>
-#include <backends/imgui_impl_opengl3.h>
 #include <glad/gl.h>
-#include <imgui.h>
 #include <spdlog/spdlog.h>
+#include "framebuffer.hpp"
 #include "math/vector.hpp"
+#include "platform.hpp"
 #include "utils/assertion.hpp"
 
-#ifndef NDEBUG
-static void GLAPIENTRY debugMessageCallback(GLenum, GLenum type, GLuint, GLenum severity, GLsizei, const GLchar* message, const void*)
+Window::Window(Platform& platform, const std::string& title, const Vector2i& size, bool primary)
+    : platform{ platform }
+    , primary{ primary }
+    , framebuffer{ 0 }
 {
-    if (severity == GL_DEBUG_SEVERITY_HIGH
-        || severity == GL_DEBUG_SEVERITY_MEDIUM
-        || severity == GL_DEBUG_SEVERITY_LOW) {
-        if (type == GL_DEBUG_TYPE_ERROR)
-            spdlog::error("{}", message);
-        else
-            spdlog::warn("{}", message);
-    }
-}
-#endif
-
-Window::Window(const std::string& title, const Vector2i& size)
-{
-    Assert(size.x > 0 && size.y > 0);
+    Assert(platform && size.x > 0 && size.y > 0);
 
     spdlog::info("Creating window '{}' ({}x{})", title, size.x, size.y);
 
-    glfwSetErrorCallback([](int, const char* description) {
-        spdlog::error("GLFW error: {}", description);
-    });
-
-    if (!glfwInit())
-        goto error_init;
-
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
-#ifndef NDEBUG
-    glfwWindowHint(GLFW_CONTEXT_DEBUG, GLFW_TRUE);
-#endif
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    window = glfwCreateWindow(size.x, size.y, title.c_str(), nullptr, nullptr);
+    window = glfwCreateWindow(size.x, size.y, title.c_str(), nullptr, platform.getContext());
     if (!window)
-        goto error_window;
+        return;
 
+    // Framebuffer objects are not shared between contexts.
     glfwMakeContextCurrent(window);
+    glfwSwapInterval(primary ? 1 : 0);
+    glCreateFramebuffers(1, &framebuffer);
+    platform.makeCurrent();
 
-    if (!gladLoadGL(glfwGetProcAddress)) {
-        spdlog::error("Unable to load OpenGL");
-        goto error_glad;
-    }
-
-#ifndef NDEBUG
-    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-    glDebugMessageCallback(debugMessageCallback, nullptr);
-#endif
-
-    glEnable(GL_CULL_FACE);
-    glEnable(GL_DEPTH_TEST);
-
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-    ImGui_ImplGlfw_InitForOpenGL(window, true);
-    ImGui_ImplOpenGL3_Init();
-
-    return;
-
-error_glad:
-    glfwDestroyWindow(window);
-error_window:
-    glfwTerminate();
-error_init:
-    window = nullptr;
+    if (primary)
+        platform.attachOverlay(window);
 }
 
 Window::~Window()
@@ -84,12 +38,14 @@ Window::~Window()
     if (!window)
         return;
 
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
+    if (primary)
+        platform.detachOverlay();
+
+    glfwMakeContextCurrent(window);
+    glDeleteFramebuffers(1, &framebuffer);
+    platform.makeCurrent();
 
     glfwDestroyWindow(window);
-    glfwTerminate();
 }
 
 bool Window::shouldClose() const
@@ -109,28 +65,40 @@ Vector2i Window::getSize() const
     return Vector2i{ width, height };
 }
 
-void Window::beginFrame()
+void Window::present(const Framebuffer& image, GLsync fence)
 {
-    Assert(window);
-
-    glfwPollEvents();
-
-    ImGui_ImplOpenGL3_NewFrame();
-    ImGui_ImplGlfw_NewFrame();
-    ImGui::NewFrame();
+    Assert(window && fence);
 
     const Vector2i size = getSize();
-    glViewport(0, 0, size.x, size.y);
-
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-}
+    if (size.x == 0 || size.y == 0)
+        return;
 
-void Window::endFrame()
-{
-    Assert(window);
+    // The window context is made current once per frame, the resource
+    // context only comes back once the buffers are swapped.
+    glfwMakeContextCurrent(window);
+    glWaitSync(fence, 0, GL_TIMEOUT_IGNORED);
+
+    // Letterboxed.
+    const Vector2i& imageSize = image.getSize();
+    const float scale = std::min(size.x / static_cast<float>(imageSize.x), size.y / static_cast<float>(imageSize.y));
+    const int width = static_cast<int>(imageSize.x * scale);
+    const int height = static_cast<int>(imageSize.y * scale);
+    const int x = (size.x - width) / 2;
+    const int y = (size.y - height) / 2;
+
+    // The image may have been reallocated since last frame.
+    glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, image.getColorTexture(), 0);
+
+    if (width != size.x || height != size.y) {
+        const GLfloat black[4] = { 0, 0, 0, 1 };
+        glClearNamedFramebufferfv(0, GL_COLOR, 0, black);
+    }
 
-    ImGui::Render();
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    glBlitNamedFramebuffer(framebuffer, 0,
+        0, 0, imageSize.x, imageSize.y,
+        x, y, x + width, y + height,
+        GL_COLOR_BUFFER_BIT, GL_LINEAR);
 
     glfwSwapBuffers(window);
+    platform.makeCurrent();
 }